@@ -0,0 +1,448 @@
+#include "../include/TaskScheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Synthetic workload benchmark for TaskScheduler.
+//
+// Usage: task_scheduler_bench [--sizes 1000,10000,...] [--lanes N] [--granularity MINUTES]
+//                             [--horizon DAYS] [--output results.json]
+//
+// For every task count, calendar density and priority mix it times the main
+// scheduler operations and writes ns/op, throughput and peak RSS as JSON.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using TimePoint = std::chrono::system_clock::time_point;
+
+struct CalendarDensity {
+    std::string name;
+    int eventsPerDay;
+};
+
+struct PriorityMix {
+    std::string name;
+    std::array<double, 4> weights;   // LOW, MEDIUM, HIGH, URGENT
+};
+
+struct Result {
+    std::size_t tasks;
+    std::size_t lanes;
+    long granularity;
+    long horizonDays;
+    std::string density;
+    std::string mix;
+    std::string operation;
+    std::size_t ops;
+    long long totalNs;
+    long peakRssKb;
+};
+
+// Calendar events are generated over this many days from now
+constexpr int kCalendarDays = 365;
+
+long peakRssKb() {
+#if defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;   // bytes on macOS
+#elif defined(__unix__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;          // kilobytes on Linux
+#else
+    return 0;
+#endif
+}
+
+long long elapsedNs(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+std::vector<std::shared_ptr<Task>> makeTasks(std::size_t count, const PriorityMix& mix,
+                                             std::mt19937_64& rng, TimePoint now) {
+    std::discrete_distribution<int> priority(mix.weights.begin(), mix.weights.end());
+    std::uniform_int_distribution<int> duration(15, 240);
+    std::uniform_int_distribution<int> deadlineHours(-48, 24 * 180);
+
+    std::vector<std::shared_ptr<Task>> tasks;
+    tasks.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        tasks.push_back(std::make_shared<Task>(
+            "task-" + std::to_string(i),
+            std::chrono::minutes(duration(rng)),
+            static_cast<Priority>(priority(rng)),
+            now + std::chrono::hours(deadlineHours(rng))));
+    }
+    return tasks;
+}
+
+void addEvents(TaskScheduler& scheduler, const CalendarDensity& density,
+               std::mt19937_64& rng, TimePoint now) {
+    std::uniform_int_distribution<int> offset(0, 24 * 60 - 1);
+    std::uniform_int_distribution<int> length(15, 90);
+    for (int day = 0; day < kCalendarDays; ++day) {
+        for (int e = 0; e < density.eventsPerDay; ++e) {
+            auto start = now + std::chrono::hours(24 * day) + std::chrono::minutes(offset(rng));
+            scheduler.addCalendarEvent(start, start + std::chrono::minutes(length(rng)),
+                                       "event-" + std::to_string(e));
+        }
+    }
+}
+
+void runScenario(std::size_t count, std::size_t lanes, std::chrono::minutes granularity, int horizonDays,
+                 const CalendarDensity& density, const PriorityMix& mix,
+                 std::uint64_t seed, std::vector<Result>& results) {
+    std::mt19937_64 rng(seed);
+    auto now = std::chrono::system_clock::now();
+    auto tasks = makeTasks(count, mix, rng, now);
+
+    auto record = [&](const std::string& operation, std::size_t ops, long long totalNs) {
+        results.push_back(Result{count, lanes, static_cast<long>(granularity.count()), horizonDays, density.name, mix.name, operation, ops, totalNs, peakRssKb()});
+        std::cerr << "  " << operation << ": " << (ops ? totalNs / static_cast<long long>(ops) : 0)
+                  << " ns/op\n";
+    };
+
+    // Bulk load on a scheduler of its own
+    {
+        TaskScheduler bulk;
+        auto start = Clock::now();
+        bulk.addTasks(tasks);
+        record("addTasks", count, elapsedNs(start));
+    }
+
+    TaskScheduler scheduler;
+    scheduler.setLaneCount(lanes);
+    scheduler.setTimeGranularity(granularity);
+    scheduler.setSchedulingHorizon(std::chrono::hours(24 * horizonDays));
+    addEvents(scheduler, density, rng, now);
+
+    auto start = Clock::now();
+    for (const auto& task : tasks) {
+        scheduler.addTask(task);
+    }
+    record("addTask", count, elapsedNs(start));
+
+    start = Clock::now();
+    scheduler.scheduleTasks();
+    record("scheduleTasks", count, elapsedNs(start));
+
+    // Typical edit: complete a task near the tail of the schedule, then reflow
+    {
+        std::vector<std::string> tail;
+        for (auto p : {Priority::LOW, Priority::MEDIUM, Priority::HIGH, Priority::URGENT}) {
+            auto lowest = scheduler.getTasksByPriority(p);
+            auto keep = std::min(lowest.size(), std::max<std::size_t>(1, count / 10));
+            for (auto it = std::prev(lowest.end(), static_cast<std::ptrdiff_t>(keep)); it != lowest.end(); ++it) {
+                tail.push_back((*it)->getName());
+            }
+            if (!tail.empty()) break;
+        }
+        std::size_t rounds = std::min<std::size_t>(20, tail.size());
+        std::uniform_int_distribution<std::size_t> pick(0, tail.size() - 1);
+        long long total = 0;
+        for (std::size_t i = 0; i < rounds; ++i) {
+            scheduler.getTask(tail[pick(rng)])->setCompleted(true);
+            start = Clock::now();
+            scheduler.rescheduleTasks();
+            total += elapsedNs(start);
+        }
+        record("rescheduleTasks", rounds, total);
+    }
+
+    {
+        const std::size_t queries = 20;
+        std::size_t sink = 0;
+        start = Clock::now();
+        for (std::size_t i = 0; i < queries; ++i) {
+            sink += scheduler.getTasksByPriority(static_cast<Priority>(i % 4)).size();
+        }
+        record("getTasksByPriority", queries, elapsedNs(start));
+
+        start = Clock::now();
+        for (std::size_t i = 0; i < queries; ++i) {
+            sink += scheduler.getOverdueTasks().size();
+        }
+        record("getOverdueTasks", queries, elapsedNs(start));
+        if (sink == static_cast<std::size_t>(-1)) std::cerr << sink;
+    }
+
+    // What-if evaluation on forks: an URGENT task arriving now
+    {
+        const std::size_t forks = 1000;
+        start = Clock::now();
+        for (std::size_t i = 0; i < forks; ++i) {
+            scheduler.fork();
+        }
+        record("fork", forks, elapsedNs(start));
+
+        const std::size_t questions = 2;
+        std::size_t late = 0;
+        start = Clock::now();
+        for (std::size_t i = 0; i < questions; ++i) {
+            auto whatIf = scheduler.fork();
+            whatIf->addTask("what-if " + std::to_string(i), std::chrono::minutes(60), Priority::URGENT,
+                            now + std::chrono::hours(2));
+            whatIf->rescheduleTasks();
+            late += whatIf->getFeasibilityReport().lateTasks.size();
+        }
+        record("whatIf", questions, elapsedNs(start));
+        if (late == static_cast<std::size_t>(-1)) std::cerr << late;
+
+        // The owner's first writes while a fork is still alive, as after
+        // every publish(): an add and a remove, each copying what it touches
+        const std::size_t writes = 100;
+        long long total = 0;
+        for (std::size_t i = 0; i < writes; ++i) {
+            auto published = scheduler.fork();
+            start = Clock::now();
+            auto handle = scheduler.addTask("after fork " + std::to_string(i), std::chrono::minutes(30),
+                                            Priority::LOW, now + std::chrono::hours(48));
+            total += elapsedNs(start);
+            published = scheduler.fork();
+            start = Clock::now();
+            scheduler.removeTask(handle);
+            total += elapsedNs(start);
+        }
+        record("writeAfterFork", 2 * writes, total);
+    }
+
+    // Cold start from a snapshot instead of re-adding every task
+    {
+        const std::string path = "task_scheduler_bench.snapshot";
+        start = Clock::now();
+        bool saved = scheduler.saveSnapshot(path);
+        record("saveSnapshot", 1, elapsedNs(start));
+
+        start = Clock::now();
+        auto loaded = TaskScheduler::loadSnapshot(path);
+        record("loadSnapshot", 1, elapsedNs(start));
+        if (!saved || !loaded || loaded->getTaskCount() != scheduler.getTaskCount()) {
+            std::cerr << "  snapshot round trip failed\n";
+        }
+        std::remove(path.c_str());
+    }
+
+    // Journaled adds and completions, made durable by one group commit
+    {
+        const std::string directory = "task_scheduler_bench.journal";
+        const std::size_t completions = std::min<std::size_t>(count, 10000);
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+        {
+            Journal journal(directory);
+            auto journaled = journal.recover();
+            start = Clock::now();
+            for (std::size_t i = 0; i < completions; ++i) {
+                journaled->addTask(tasks[i]->getName(), tasks[i]->getDuration(), tasks[i]->getPriority(),
+                                   tasks[i]->getDeadline());
+                journaled->completeTask(tasks[i]->getName());
+            }
+            journal.sync();
+            record("journaledMutation", 2 * completions, elapsedNs(start));
+        }
+        std::filesystem::remove_all(directory, error);
+    }
+
+    // Monte Carlo risk of the plan, with every duration between
+    // -25% and +100% of its planned value. One op is one task in one pass.
+    {
+        for (auto p : {Priority::LOW, Priority::MEDIUM, Priority::HIGH, Priority::URGENT}) {
+            for (auto handle : scheduler.getTaskHandlesByPriority(p)) {
+                auto duration = scheduler.getTaskStore().duration(handle);
+                scheduler.setDurationEstimate(handle, {duration * 3 / 4, duration, duration * 2});
+            }
+        }
+        Executor executor;
+        TaskScheduler::RiskOptions options;
+        options.iterations = 200;
+        options.samples = 200;
+        start = Clock::now();
+        auto report = scheduler.simulateRisk(executor, options);
+        record("simulateRisk", report.tasks.size() * options.iterations, elapsedNs(start));
+    }
+
+    // Start and deadline timers for every task, then a full pass that
+    // cancels and re-arms all of them
+    {
+        std::atomic<std::size_t> fired{0};
+        start = Clock::now();
+        scheduler.startNotifications([&](TaskScheduler::TaskHandle, TaskScheduler::Notification) { ++fired; });
+        record("startNotifications", scheduler.getTaskCount(), elapsedNs(start));
+
+        start = Clock::now();
+        scheduler.scheduleTasks();
+        record("scheduleTasksNotified", scheduler.getTaskCount(), elapsedNs(start));
+        scheduler.stopNotifications();
+    }
+
+    // Priority bumps through the bound Task objects, then one reflow
+    {
+        const std::size_t bumps = std::min<std::size_t>(count, 10000);
+        std::uniform_int_distribution<std::size_t> pick(0, count - 1);
+        start = Clock::now();
+        for (std::size_t i = 0; i < bumps; ++i) {
+            tasks[pick(rng)]->setPriority(static_cast<Priority>(i % 4));
+        }
+        record("changePriority", bumps, elapsedNs(start));
+
+        start = Clock::now();
+        scheduler.rescheduleTasks();
+        record("rescheduleAfterPriorityChanges", 1, elapsedNs(start));
+    }
+
+    // Mutations on random existing names
+    std::size_t mutations = std::min<std::size_t>(count, 10000);
+    std::vector<std::size_t> order(count);
+    for (std::size_t i = 0; i < count; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<std::shared_ptr<Task>> replacements;
+    replacements.reserve(mutations);
+    for (std::size_t i = 0; i < mutations; ++i) {
+        const auto& old = tasks[order[i]];
+        replacements.push_back(std::make_shared<Task>(
+            old->getName(), old->getDuration() + std::chrono::minutes(15),
+            old->getPriority(), old->getDeadline()));
+    }
+    start = Clock::now();
+    for (const auto& task : replacements) {
+        scheduler.updateTask(task->getName(), task);
+    }
+    record("updateTask", mutations, elapsedNs(start));
+
+    start = Clock::now();
+    for (std::size_t i = 0; i < mutations; ++i) {
+        scheduler.removeTask(tasks[order[i]]->getName());
+    }
+    record("removeTask", mutations, elapsedNs(start));
+
+    // Run every remaining task on the executor with a trivial payload
+    {
+        std::atomic<std::size_t> runs{0};
+        for (auto p : {Priority::LOW, Priority::MEDIUM, Priority::HIGH, Priority::URGENT}) {
+            for (const auto& task : scheduler.getTasksByPriority(p)) {
+                task->setPayload([&runs] { runs.fetch_add(1, std::memory_order_relaxed); });
+            }
+        }
+        Executor executor;
+        start = Clock::now();
+        auto dispatched = scheduler.dispatchTasks(executor);
+        executor.wait();
+        scheduler.processCompletions();
+        record("executeTasks", dispatched, elapsedNs(start));
+    }
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results) {
+    out << "{\n  \"benchmark\": \"task_scheduler\",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        double nsPerOp = r.ops ? static_cast<double>(r.totalNs) / r.ops : 0.0;
+        double opsPerSec = r.totalNs ? r.ops * 1e9 / r.totalNs : 0.0;
+        out << "    {\"tasks\": " << r.tasks
+            << ", \"lanes\": " << r.lanes
+            << ", \"granularity_min\": " << r.granularity
+            << ", \"horizon_days\": " << r.horizonDays
+            << ", \"calendar_density\": \"" << r.density << "\""
+            << ", \"priority_mix\": \"" << r.mix << "\""
+            << ", \"operation\": \"" << r.operation << "\""
+            << ", \"ops\": " << r.ops
+            << ", \"total_ns\": " << r.totalNs
+            << ", \"ns_per_op\": " << nsPerOp
+            << ", \"ops_per_sec\": " << opsPerSec
+            << ", \"peak_rss_kb\": " << r.peakRssKb << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+std::vector<std::size_t> parseSizes(const std::string& text) {
+    std::vector<std::size_t> sizes;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            sizes.push_back(std::stoul(item));
+        }
+    }
+    return sizes;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::size_t> sizes = {1000, 10000, 100000, 1000000};
+    std::size_t lanes = 1;
+    std::chrono::minutes granularity{0};
+    int horizonDays = 0;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            sizes = parseSizes(argv[++i]);
+        } else if (arg == "--lanes" && i + 1 < argc) {
+            lanes = std::stoul(argv[++i]);
+        } else if (arg == "--granularity" && i + 1 < argc) {
+            granularity = std::chrono::minutes(std::stol(argv[++i]));
+        } else if (arg == "--horizon" && i + 1 < argc) {
+            horizonDays = std::stoi(argv[++i]);
+        } else if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--sizes 1000,10000] [--lanes N] [--granularity MINUTES]"
+                      << " [--horizon DAYS] [--output file.json]\n";
+            return 1;
+        }
+    }
+
+    const std::vector<CalendarDensity> densities = {
+        {"none", 0},
+        {"sparse", 4},
+        {"dense", 32},
+    };
+    const std::vector<PriorityMix> mixes = {
+        {"uniform", {0.25, 0.25, 0.25, 0.25}},
+        {"skewed", {0.70, 0.20, 0.08, 0.02}},
+    };
+
+    std::vector<Result> results;
+    std::uint64_t seed = 1;
+    for (auto size : sizes) {
+        for (const auto& density : densities) {
+            for (const auto& mix : mixes) {
+                std::cerr << size << " tasks, " << density.name << " calendar, "
+                          << mix.name << " priorities\n";
+                runScenario(size, lanes, granularity, horizonDays, density, mix, seed++, results);
+            }
+        }
+    }
+
+    if (output.empty()) {
+        writeJson(std::cout, results);
+    } else {
+        std::ofstream file(output);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open output file: " << output << std::endl;
+            return 1;
+        }
+        writeJson(file, results);
+    }
+    return 0;
+}
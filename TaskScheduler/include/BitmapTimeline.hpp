@@ -0,0 +1,72 @@
+#pragma once
+
+#include "CowHashMap.hpp"
+#include "CowSet.hpp"
+#include "CowVector.hpp"
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+// Busy time as a bitmap with one bit per quantum of `granularity`.
+//
+// Drop-in alternative to IntervalIndex for dense calendars: busy intervals
+// are rounded out to whole quanta, and fits always start on a quantum
+// boundary. Marking and unmarking touch len/64 words. findFirstFit() tests
+// 64 quanta per step with word-level run tricks and skips fully booked
+// stretches through a second bitmap with one bit per full word.
+//
+// Only the span between the earliest and latest busy quantum is stored;
+// everything outside it is free. All of it is held in copy-on-write
+// containers, so copying a timeline is O(1) and the first change after a
+// copy clones only the pages of bits and intervals it touches.
+class BitmapTimeline {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+    using Duration = TimePoint::duration;
+    using Key = std::uint64_t;
+
+    explicit BitmapTimeline(const Duration& granularity);
+
+    // Interval management
+    void insert(Key key, const TimePoint& start, const TimePoint& end);
+    bool erase(Key key);
+    bool contains(Key key) const { return intervals_.count(key) != 0; }
+    void clear();
+    std::size_t size() const { return intervals_.size(); }
+    Duration granularity() const { return granularity_; }
+
+    // Queries
+    bool isFree(const TimePoint& start, const TimePoint& end) const;
+    TimePoint findFirstFit(const TimePoint& from, const Duration& duration) const;
+    TimePoint end() const;   // everything from here on is free; min() when empty
+
+private:
+    // Quanta [first, last), counted from the clock's epoch
+    struct Interval {
+        std::int64_t first;
+        std::int64_t last;
+    };
+
+    Duration granularity_;
+
+    // Raw intervals, needed to restore overlapped bits after an erase
+    CowHashMap<Key, Interval> intervals_;
+    CowSet<std::pair<std::int64_t, Key>> byFirst_;
+    CowSet<std::int64_t> lengths_;   // bounds how far back an overlap can start
+
+    // Bit i of words_[w] is quantum (baseWord_ + w) * 64 + i; set means busy.
+    // Bit w of full_ says words_[w] is all ones.
+    std::int64_t baseWord_ = 0;
+    CowVector<std::uint64_t> words_;
+    CowVector<std::uint64_t> full_;
+
+    // Bit helpers
+    std::int64_t quantumFloor(const TimePoint& time) const;
+    std::int64_t quantumCeil(const TimePoint& time) const;
+    TimePoint timeOf(std::int64_t quantum) const;
+    void cover(std::int64_t first, std::int64_t last);
+    void mark(std::int64_t first, std::int64_t last);
+    void unmark(std::int64_t first, std::int64_t last);
+    void updateFull(std::size_t word);
+    std::size_t nextNonFull(std::size_t word) const;
+};
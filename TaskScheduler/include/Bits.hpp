@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_bitops)
+#include <bit>
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Bit scans of a non-zero 64-bit word: <bit> where the standard library has
+// it, compiler intrinsics otherwise.
+inline int countTrailingZeros(std::uint64_t word) {
+#if defined(__cpp_lib_bitops)
+    return std::countr_zero(word);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+inline int countLeadingZeros(std::uint64_t word) {
+#if defined(__cpp_lib_bitops)
+    return std::countl_zero(word);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return 63 - static_cast<int>(index);
+#else
+    return __builtin_clzll(word);
+#endif
+}
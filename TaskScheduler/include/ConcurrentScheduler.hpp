@@ -0,0 +1,105 @@
+#pragma once
+
+#include "TaskScheduler.hpp"
+#include "MpscQueue.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Read-only state of a TaskScheduler after a fully applied batch.
+//
+// It holds a copy-on-write fork of the scheduler, so publishing one is O(1)
+// whatever the task count, and the writer's next batch copies only the pages
+// it changes while the snapshot is alive. Reads go through handles and the store's column
+// accessors, which any number of threads may use at once; the fork's Task
+// object API is not exposed since it creates objects on demand.
+struct SchedulerSnapshot {
+    using TaskHandle = TaskScheduler::TaskHandle;
+
+    struct TaskInfo {
+        std::string name;
+        std::chrono::minutes duration;
+        Priority priority;
+        std::chrono::system_clock::time_point deadline;
+        std::chrono::system_clock::time_point scheduledTime;
+        bool completed;
+    };
+
+    std::uint64_t version = 0;      // number of batches applied
+
+    SchedulerSnapshot();
+    SchedulerSnapshot(const SchedulerSnapshot&) = delete;
+    SchedulerSnapshot& operator=(const SchedulerSnapshot&) = delete;
+
+    std::size_t size() const { return scheduler_->getTaskCount(); }
+    // Handles of a priority in scheduling order; higher priorities go first
+    std::vector<TaskHandle> tasks(Priority priority) const {
+        return scheduler_->getTaskHandlesByPriority(priority);
+    }
+    const TaskStore& store() const { return scheduler_->getTaskStore(); }
+    std::optional<TaskInfo> find(const std::string& name) const;
+
+private:
+    friend class ConcurrentScheduler;
+    std::unique_ptr<const TaskScheduler> scheduler_;
+};
+
+// Thread-safe front end for a TaskScheduler.
+//
+// Any number of threads push mutations into a lock-free MPSC queue and
+// return immediately. One owner thread drains the queue in batches, applies
+// each batch to the scheduler it owns, reschedules once and then publishes
+// a new immutable snapshot. Readers only ever load the latest snapshot, so
+// writers never block them and they never see half of a batch.
+//
+// Tasks passed in are copied when the mutation is queued; the caller keeps
+// its Task objects and reads scheduler state through snapshots.
+class ConcurrentScheduler {
+public:
+    using Mutation = std::function<void(TaskScheduler&)>;
+
+    ConcurrentScheduler();
+    ~ConcurrentScheduler();
+    ConcurrentScheduler(const ConcurrentScheduler&) = delete;
+    ConcurrentScheduler& operator=(const ConcurrentScheduler&) = delete;
+
+    // Producers
+    void addTask(const std::shared_ptr<Task>& task);
+    void updateTask(const std::string& taskName, const std::shared_ptr<Task>& newTask);
+    void removeTask(const std::string& taskName);
+    void completeTask(const std::string& taskName);
+    void submit(Mutation mutation);   // runs on the owner thread
+
+    // Readers
+    std::shared_ptr<const SchedulerSnapshot> snapshot() const;
+
+    // Blocks until everything queued before the call is visible in a snapshot
+    void flush();
+
+private:
+    static constexpr std::size_t kMaxBatch = 4096;
+
+    TaskScheduler scheduler_;   // touched by the owner thread only
+    MpscQueue<Mutation> queue_;
+    std::shared_ptr<const SchedulerSnapshot> snapshot_;   // atomic_load / atomic_store only
+
+    std::atomic<std::uint64_t> queued_{0};
+    std::atomic<std::uint64_t> published_{0};
+    std::atomic<bool> ownerSleeping_{false};
+    std::atomic<bool> stopping_{false};
+
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable batchPublished_;
+    std::thread owner_;
+
+    void run();
+    void publish(std::uint64_t version);
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "CowPtr.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Hash map split by hash into shards of about kShardSize entries, each of
+// them a CowPtr.
+//
+// Copying a CowHashMap is O(1). The first write after a copy clones the
+// shard table, which holds one pointer per shard, and the shard it writes
+// to; other shards stay shared. The shard count doubles whenever the map
+// outgrows it, which rehashes every entry once, so growth stays amortized
+// O(1) per insert.
+//
+// Lookups are const and hand out a pointer to the value, or nullptr; values
+// are changed through insertOrAssign().
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class CowHashMap {
+public:
+    static constexpr std::size_t kShardSize = 256;
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const Value* find(const Key& key) const {
+        const auto& shard = *(*shards_)[shardOf(key)];
+        auto it = shard.find(key);
+        return it != shard.end() ? &it->second : nullptr;
+    }
+    std::size_t count(const Key& key) const { return find(key) != nullptr; }
+
+    // Leaves an existing entry alone and returns false
+    bool emplace(const Key& key, const Value& value) {
+        if (find(key)) {
+            return false;
+        }
+        grow(size_ + 1);
+        (*shards_)[shardOf(key)]->emplace(key, value);
+        ++size_;
+        return true;
+    }
+
+    void insertOrAssign(const Key& key, const Value& value) {
+        if (!emplace(key, value)) {
+            (*(*shards_)[shardOf(key)])[key] = value;
+        }
+    }
+
+    bool erase(const Key& key) {
+        if (!find(key)) {
+            return false;
+        }
+        (*shards_)[shardOf(key)]->erase(key);
+        --size_;
+        return true;
+    }
+
+    void clear() {
+        shards_ = Shards(std::in_place, 1);
+        bits_ = 0;
+        size_ = 0;
+    }
+
+    void reserve(std::size_t count) { grow(count); }
+
+private:
+    using Shard = std::unordered_map<Key, Value, Hash>;
+    using Shards = CowPtr<std::vector<CowPtr<Shard>>>;
+
+    Shards shards_{std::in_place, 1};
+    unsigned bits_ = 0;   // log2 of the shard count
+    std::size_t size_ = 0;
+    Hash hash_;
+
+    // Top bits of the scrambled hash, so doubling splits shard i into 2i and 2i + 1
+    std::size_t shardOf(const Key& key) const {
+        if (bits_ == 0) {
+            return 0;
+        }
+        auto mixed = static_cast<std::uint64_t>(hash_(key)) * 0x9e3779b97f4a7c15ull;
+        return static_cast<std::size_t>(mixed >> (64 - bits_));
+    }
+
+    void grow(std::size_t count) {
+        unsigned bits = bits_;
+        while ((kShardSize << bits) < count) {
+            ++bits;
+        }
+        if (bits == bits_) {
+            return;
+        }
+
+        Shards old = shards_;
+        bits_ = bits;
+        shards_ = Shards(std::in_place, std::size_t(1) << bits);
+        for (const auto& shard : *std::as_const(old)) {
+            for (const auto& [key, value] : *shard) {
+                (*shards_)[shardOf(key)]->emplace(key, value);
+            }
+        }
+    }
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+// Implicitly shared value. Copies share one T until one of them needs
+// write access, which clones the value first ("detach"), so copying a
+// CowPtr is O(1) however large T is.
+//
+// Const access never detaches; non-const access always makes sure the
+// value is owned exclusively. Copies may be used from different threads.
+template <typename T>
+class CowPtr {
+public:
+    CowPtr() : ptr_(std::make_shared<T>()) {}
+
+    template <typename... Args>
+    explicit CowPtr(std::in_place_t, Args&&... args)
+        : ptr_(std::make_shared<T>(std::forward<Args>(args)...)) {}
+
+    const T& operator*() const { return *ptr_; }
+    const T* operator->() const { return ptr_.get(); }
+
+    T& operator*() {
+        detach();
+        return *ptr_;
+    }
+    T* operator->() {
+        detach();
+        return ptr_.get();
+    }
+
+    bool isShared() const { return ptr_.use_count() > 1; }
+
+private:
+    std::shared_ptr<T> ptr_;
+
+    void detach() {
+        if (ptr_.use_count() > 1) {
+            ptr_ = std::make_shared<T>(*ptr_);
+        } else {
+            // Pairs with the release of the last other owner
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+    }
+};
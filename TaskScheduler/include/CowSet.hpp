@@ -0,0 +1,210 @@
+#pragma once
+
+#include "CowPtr.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// Sorted multiset stored as a table of page-sized sorted runs, each of them
+// a CowPtr.
+//
+// Copying a CowSet is O(1). The first write after a copy clones the page
+// table, which holds one pointer per page, and the page it writes to;
+// other pages stay shared. A search is a binary search over the page table
+// followed by one inside the page, an insert or erase shifts at most one
+// page. Full pages split in half, except that appending to the last page
+// starts a new one, so sorted input fills pages completely; neighbouring
+// pages that shrink to half a page between them are merged.
+//
+// Equal elements are kept in insertion order and erase() removes the first
+// of them. Iteration is const only; any insert or erase invalidates
+// iterators.
+template <typename T, typename Compare = std::less<T>>
+class CowSet {
+public:
+    // Most elements per page: as many as fit in 4 KiB, rounded down to a power of two
+    static constexpr std::size_t kPageSize = [] {
+        std::size_t size = 1;
+        while (size * 2 * sizeof(T) <= 4096) {
+            size *= 2;
+        }
+        return size;
+    }();
+
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+        const_iterator(const CowSet* set, std::size_t page, std::size_t index)
+            : set_(set), page_(page), index_(index) {}
+
+        reference operator*() const { return (*set_->table_->pages[page_])[index_]; }
+        pointer operator->() const { return &**this; }
+
+        const_iterator& operator++() {
+            if (++index_ == set_->pageSize(page_)) {
+                ++page_;
+                index_ = 0;
+            }
+            return *this;
+        }
+        const_iterator operator++(int) { const_iterator copy = *this; ++*this; return copy; }
+        const_iterator& operator--() {
+            if (index_ == 0) {
+                index_ = set_->pageSize(--page_);
+            }
+            --index_;
+            return *this;
+        }
+        const_iterator operator--(int) { const_iterator copy = *this; --*this; return copy; }
+
+        bool operator==(const const_iterator& other) const { return page_ == other.page_ && index_ == other.index_; }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class CowSet;
+
+        const CowSet* set_ = nullptr;
+        std::size_t page_ = 0;
+        std::size_t index_ = 0;
+    };
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(this, table_->pages.size(), 0); }
+
+    const_iterator lower_bound(const T& value) const {
+        std::size_t page = findPage(value, false);
+        if (page == table_->pages.size()) {
+            return end();
+        }
+        const auto& elements = *table_->pages[page];
+        auto at = std::lower_bound(elements.begin(), elements.end(), value, compare_);
+        return const_iterator(this, page, static_cast<std::size_t>(at - elements.begin()));
+    }
+    const_iterator upper_bound(const T& value) const {
+        std::size_t page = findPage(value, true);
+        if (page == table_->pages.size()) {
+            return end();
+        }
+        const auto& elements = *table_->pages[page];
+        auto at = std::upper_bound(elements.begin(), elements.end(), value, compare_);
+        return const_iterator(this, page, static_cast<std::size_t>(at - elements.begin()));
+    }
+
+    void insert(const T& value) {
+        auto& table = *table_;
+        ++size_;
+        if (table.pages.empty()) {
+            table.pages.emplace_back(std::in_place, 1, value);
+            table.lasts.push_back(value);
+            return;
+        }
+        std::size_t index = std::min(findPage(value, true), table.pages.size() - 1);
+        auto& page = *table.pages[index];
+        auto at = std::upper_bound(page.begin(), page.end(), value, compare_);
+        bool append = at == page.end() && index + 1 == table.pages.size();
+        page.insert(at, value);
+
+        if (page.size() > kPageSize) {
+            std::size_t keep = append ? kPageSize : page.size() / 2;
+            CowPtr<std::vector<T>> rest(std::in_place, page.begin() + keep, page.end());
+            page.erase(page.begin() + keep, page.end());
+            table.lasts.insert(table.lasts.begin() + index + 1, std::as_const(rest)->back());
+            table.pages.insert(table.pages.begin() + index + 1, std::move(rest));
+        }
+        table.lasts[index] = page.back();
+    }
+
+    // Removes one element equal to `value`, if there is one
+    bool erase(const T& value) {
+        auto found = lower_bound(value);
+        if (found == end() || compare_(value, *found)) {
+            return false;
+        }
+
+        auto& table = *table_;
+        std::size_t index = found.page_;
+        auto& page = *table.pages[index];
+        page.erase(page.begin() + found.index_);
+        --size_;
+
+        if (page.empty()) {
+            removePage(table, index);
+        } else if (index + 1 < table.pages.size() && page.size() + pageSize(index + 1) <= kPageSize / 2) {
+            const auto& next = *std::as_const(table.pages[index + 1]);
+            page.insert(page.end(), next.begin(), next.end());
+            removePage(table, index + 1);
+            table.lasts[index] = page.back();
+        } else if (index > 0 && page.size() + pageSize(index - 1) <= kPageSize / 2) {
+            auto& previous = *table.pages[index - 1];
+            previous.insert(previous.end(), page.begin(), page.end());
+            removePage(table, index);
+            table.lasts[index - 1] = previous.back();
+        } else {
+            table.lasts[index] = page.back();
+        }
+        return true;
+    }
+
+    // Replaces the contents with a range that is already sorted
+    template <typename ForwardIt>
+    void assign(ForwardIt first, ForwardIt last) {
+        clear();
+        auto& table = *table_;
+        auto count = static_cast<std::size_t>(std::distance(first, last));
+        table.pages.reserve((count + kPageSize - 1) / kPageSize);
+        table.lasts.reserve((count + kPageSize - 1) / kPageSize);
+        for (std::size_t done = 0; done < count; done += kPageSize) {
+            auto next = std::next(first, static_cast<std::ptrdiff_t>(std::min(kPageSize, count - done)));
+            table.pages.emplace_back(std::in_place, first, next);
+            table.lasts.push_back(std::as_const(table.pages.back())->back());
+            first = next;
+        }
+        size_ = count;
+    }
+
+    void clear() {
+        table_ = CowPtr<Table>();
+        size_ = 0;
+    }
+
+private:
+    // Sorted across pages as well; no page is empty. The last element of
+    // every page is repeated in `lasts`, so finding a page is a binary
+    // search over one dense array.
+    struct Table {
+        std::vector<CowPtr<std::vector<T>>> pages;
+        std::vector<T> lasts;
+    };
+
+    CowPtr<Table> table_;
+    std::size_t size_ = 0;
+    Compare compare_;
+
+    // First page whose last element is not less than `value`, or with
+    // `after` greater than it; the page count if there is none
+    std::size_t findPage(const T& value, bool after) const {
+        const auto& lasts = table_->lasts;
+        auto at = after ? std::upper_bound(lasts.begin(), lasts.end(), value, compare_)
+                        : std::lower_bound(lasts.begin(), lasts.end(), value, compare_);
+        return static_cast<std::size_t>(at - lasts.begin());
+    }
+
+    std::size_t pageSize(std::size_t index) const { return table_->pages[index]->size(); }
+
+    static void removePage(Table& table, std::size_t index) {
+        table.pages.erase(table.pages.begin() + index);
+        table.lasts.erase(table.lasts.begin() + index);
+    }
+};
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Vector stored as a table of page-sized chunks that copies share.
+//
+// Copying a CowVector is O(1). The first write after a copy clones the page
+// table, which holds one pointer per kPageSize elements, and the page it
+// writes to; other pages stay shared. Writing to n different pages thus
+// costs O(n * kPageSize) however large the vector is.
+//
+// Const access never detaches, non-const access detaches the page it
+// touches, as with CowPtr. Every vector carries an owner token that it
+// stamps on its table and on the table slots of pages it has made its own,
+// and copying a vector gives both sides new tokens; a write to a page that
+// is already owned thus costs two comparisons more than a read, and neither
+// goes through the page's reference count. Iteration is const only. Pages
+// never move, so references stay valid until their element is removed or
+// the vector is copied and written to.
+template <typename T>
+class CowVector {
+public:
+    // As many elements as fit in 4 KiB, rounded down to a power of two
+    static constexpr std::size_t kPageSize = [] {
+        std::size_t size = 1;
+        while (size * 2 * sizeof(T) <= 4096) {
+            size *= 2;
+        }
+        return size;
+    }();
+
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+        const_iterator(const CowVector* vector, std::size_t index) : vector_(vector), index_(index) {}
+
+        reference operator*() const { return (*vector_)[index_]; }
+        pointer operator->() const { return &(*vector_)[index_]; }
+        reference operator[](difference_type offset) const { return (*vector_)[index_ + offset]; }
+
+        const_iterator& operator++() { ++index_; return *this; }
+        const_iterator operator++(int) { const_iterator copy = *this; ++index_; return copy; }
+        const_iterator& operator--() { --index_; return *this; }
+        const_iterator operator--(int) { const_iterator copy = *this; --index_; return copy; }
+        const_iterator& operator+=(difference_type offset) { index_ += offset; return *this; }
+        const_iterator& operator-=(difference_type offset) { index_ -= offset; return *this; }
+        const_iterator operator+(difference_type offset) const { return const_iterator(vector_, index_ + offset); }
+        const_iterator operator-(difference_type offset) const { return const_iterator(vector_, index_ - offset); }
+        difference_type operator-(const const_iterator& other) const {
+            return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+        }
+
+        bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+        bool operator<(const const_iterator& other) const { return index_ < other.index_; }
+        bool operator>(const const_iterator& other) const { return index_ > other.index_; }
+        bool operator<=(const const_iterator& other) const { return index_ <= other.index_; }
+        bool operator>=(const const_iterator& other) const { return index_ >= other.index_; }
+
+    private:
+        const CowVector* vector_ = nullptr;
+        std::size_t index_ = 0;
+    };
+
+    CowVector() = default;
+    CowVector(const CowVector& other) : table_(other.table_), slots_(other.slots_), size_(other.size_) {
+        other.owner_ = newToken();
+    }
+    CowVector& operator=(const CowVector& other) {
+        if (this != &other) {
+            table_ = other.table_;
+            slots_ = other.slots_;
+            size_ = other.size_;
+            owner_ = newToken();
+            other.owner_ = newToken();
+        }
+        return *this;
+    }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const T& operator[](std::size_t index) const { return slots_[index / kPageSize].data[index % kPageSize]; }
+    T& operator[](std::size_t index) { return ownPage(index / kPageSize)[index % kPageSize]; }
+    const T& back() const { return (*this)[size_ - 1]; }
+    T& back() { return (*this)[size_ - 1]; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    void push_back(T value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ % kPageSize == 0) {
+            addPage(std::make_shared<Page>());
+        }
+        // A cloned page is only as large as its elements
+        std::size_t index = size_ / kPageSize;
+        ownPage(index);
+        Table& table = *table_;
+        Page& page = *table.pages[index];
+        if (page.capacity() < kPageSize) {
+            page.reserve(kPageSize);
+        }
+        page.emplace_back(std::forward<Args>(args)...);
+        table.slots[index].data = page.data();
+        ++size_;
+        return page.back();
+    }
+
+    void pop_back() {
+        std::size_t index = (size_ - 1) / kPageSize;
+        ownPage(index);
+        table_->pages[index]->pop_back();
+        if (--size_ % kPageSize == 0) {
+            table_->slots.pop_back();
+            table_->pages.pop_back();
+            slots_ = table_->slots.data();
+        }
+    }
+
+    void resize(std::size_t count, const T& value = T()) {
+        while (size_ > count) {
+            pop_back();
+        }
+        while (size_ < count) {
+            push_back(value);
+        }
+    }
+
+    void assign(std::size_t count, const T& value) {
+        clear();
+        reserve(count);
+        for (std::size_t done = 0; done < count; done += kPageSize) {
+            addPage(std::make_shared<Page>(std::min(kPageSize, count - done), value));
+        }
+        size_ = count;
+    }
+
+    // Fills whole pages at a time, so contiguous input is copied in bulk
+    template <typename ForwardIt, typename = typename std::iterator_traits<ForwardIt>::iterator_category>
+    void assign(ForwardIt first, ForwardIt last) {
+        clear();
+        auto count = static_cast<std::size_t>(std::distance(first, last));
+        reserve(count);
+        for (std::size_t done = 0; done < count; done += kPageSize) {
+            auto next = std::next(first, static_cast<std::ptrdiff_t>(std::min(kPageSize, count - done)));
+            addPage(std::make_shared<Page>(first, next));
+            first = next;
+        }
+        size_ = count;
+    }
+
+    void clear() {
+        table_ = std::make_shared<Table>();
+        slots_ = nullptr;
+        size_ = 0;
+    }
+
+    void reserve(std::size_t count) {
+        Table& table = ownTable();
+        table.slots.reserve((count + kPageSize - 1) / kPageSize);
+        table.pages.reserve((count + kPageSize - 1) / kPageSize);
+        slots_ = table.slots.data();
+    }
+
+private:
+    using Page = std::vector<T>;
+
+    // Where a page's elements are, as seen from one table. Tokens are never
+    // reused, so `owner` can only match the vector that stamped it.
+    struct Slot {
+        T* data = nullptr;
+        std::uint64_t owner = 0;
+    };
+    // Every page but the last one is full, and none is empty. The slots are
+    // kept apart from the page pointers so that lookups walk a dense array.
+    struct Table {
+        std::vector<Slot> slots;
+        std::vector<std::shared_ptr<Page>> pages;
+        std::uint64_t owner = 0;
+    };
+
+    std::shared_ptr<Table> table_ = std::make_shared<Table>();
+    Slot* slots_ = nullptr;   // table_->slots.data(), saving a hop on every access
+    std::size_t size_ = 0;
+    // Changed by copies of a const vector, which may run on several threads
+    mutable std::atomic<std::uint64_t> owner_{newToken()};
+
+    static std::uint64_t newToken() {
+        static std::atomic<std::uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void addPage(std::shared_ptr<Page> page) {
+        Table& table = ownTable();
+        table.slots.push_back(Slot{page->data(), owner_.load(std::memory_order_relaxed)});
+        table.pages.push_back(std::move(page));
+        slots_ = table.slots.data();
+    }
+
+    Table& ownTable() {
+        std::uint64_t owner = owner_.load(std::memory_order_relaxed);
+        if (table_->owner != owner) {
+            detach(table_);
+            table_->owner = owner;
+            slots_ = table_->slots.data();
+        }
+        return *table_;
+    }
+
+    // Elements of a page this vector may write to
+    T* ownPage(std::size_t index) {
+        std::uint64_t owner = owner_.load(std::memory_order_relaxed);
+        Table& table = ownTable();
+        Slot& slot = slots_[index];
+        if (slot.owner != owner) {
+            detach(table.pages[index]);
+            slot.data = table.pages[index]->data();
+            slot.owner = owner;
+        }
+        return slot.data;
+    }
+
+    // Clones a shared table or page, as CowPtr does. Kept out of line so the
+    // owned fast path of every write stays small.
+    template <typename U>
+    [[gnu::noinline]] static void detach(std::shared_ptr<U>& ptr) {
+        if (ptr.use_count() > 1) {
+            ptr = std::make_shared<U>(*ptr);
+        } else {
+            // Pairs with the release of the last other owner
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+    }
+};
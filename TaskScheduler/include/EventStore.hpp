@@ -0,0 +1,66 @@
+#pragma once
+
+#include "IntervalTree.hpp"
+#include "Recurrence.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct CalendarEvent {
+    std::chrono::system_clock::time_point start;
+    std::chrono::system_clock::time_point end;
+    std::string description;
+};
+
+// Calendar events with their full [start, end) intervals.
+//
+// Events are looked up by id, by description (hash index) and by time range
+// (interval tree), so removal and range queries never scan the whole store.
+// A recurring event is stored once with its rule; find() returns its first
+// occurrence and overlapping() leaves it out, occurrences() expands it.
+class EventStore {
+public:
+    using Id = std::uint64_t;
+    using TimePoint = std::chrono::system_clock::time_point;
+    static constexpr Id kInvalidId = ~Id(0);
+
+    // Event management
+    Id add(const TimePoint& start, const TimePoint& end, const std::string& description);
+    Id add(const TimePoint& start, const TimePoint& end, const std::string& description,
+           const RecurrenceRule& rule);
+    bool remove(Id id);
+
+    // Snapshot loading: an event under a given id, refused if the id is
+    // taken. Ids below nextId() are never handed out again.
+    bool insert(Id id, const TimePoint& start, const TimePoint& end, const std::string& description);
+    bool insert(Id id, const TimePoint& start, const TimePoint& end, const std::string& description,
+                const RecurrenceRule& rule);
+    Id nextId() const { return nextId_; }
+    void skipIds(Id next) { nextId_ = std::max(nextId_, next); }
+
+    void clear();
+
+    // Queries
+    const CalendarEvent* find(Id id) const;
+    std::vector<Id> findByDescription(const std::string& description) const;
+    std::vector<Id> overlapping(const TimePoint& from, const TimePoint& to) const;
+    std::size_t size() const { return events_.size(); }
+
+    // Recurring events
+    std::shared_ptr<const Recurrence> findRecurrence(Id id) const;
+    const std::map<Id, std::shared_ptr<const Recurrence>>& recurring() const { return recurring_; }
+    void occurrences(const TimePoint& from, const TimePoint& to, std::vector<CalendarEvent>& result) const;
+
+private:
+    std::unordered_map<Id, CalendarEvent> events_;
+    std::unordered_map<std::string, std::unordered_set<Id>> byDescription_;
+    IntervalTree byTime_;
+    std::map<Id, std::shared_ptr<const Recurrence>> recurring_;   // immutable, shared with lanes
+    Id nextId_ = 0;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Priority.hpp"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool.
+//
+// Every worker owns one deque per priority level. Jobs submitted from a
+// worker go to that worker's deques, other submissions are spread
+// round-robin. A worker looks for the highest level with queued work
+// anywhere: it takes from the front of its own deque at that level and,
+// if that is empty, steals from the back of the others'. Within a level
+// jobs are not ordered across workers, and a job already running is never
+// preempted.
+//
+// Exceptions thrown by a job are swallowed so the worker survives.
+class Executor {
+public:
+    using Job = std::function<void()>;
+
+    // Zero threads means one per hardware thread
+    explicit Executor(std::size_t threads = 0);
+    ~Executor();
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    void submit(Job job, Priority priority = Priority::MEDIUM);
+
+    // Blocks until every submitted job has finished, including jobs other
+    // callers submitted meanwhile
+    void wait();
+
+    // Group of jobs that can be waited for on its own, regardless of what
+    // else runs on the executor. Destruction waits for the group.
+    class Batch {
+    public:
+        explicit Batch(Executor& executor) : executor_(executor) {}
+        ~Batch() { wait(); }
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+        void submit(Job job, Priority priority = Priority::MEDIUM);
+        void wait();
+
+    private:
+        Executor& executor_;
+        std::mutex mutex_;
+        std::condition_variable done_;
+        std::size_t pending_ = 0;
+
+        void finish();
+    };
+
+    std::size_t getThreadCount() const { return threads_.size(); }
+
+private:
+    static constexpr std::size_t kPriorityLevels = 4;
+
+    // Padded so neighbouring workers do not share a cache line
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::array<std::deque<Job>, kPriorityLevels> jobs;   // by Priority
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<std::size_t> nextWorker_{0};
+    std::atomic<std::size_t> queued_{0};     // jobs sitting in a deque
+    std::array<std::atomic<std::size_t>, kPriorityLevels> queuedAt_{};   // per level
+    std::atomic<std::size_t> unfinished_{0}; // jobs submitted but not done
+    std::atomic<std::size_t> sleepers_{0};
+    std::atomic<bool> stopping_{false};
+
+    // Sleeping workers and wait() callers park here
+    std::mutex sleepMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable allDone_;
+
+    void workerLoop(std::size_t index);
+    bool takeJob(std::size_t index, Job& job);
+    bool takeJob(std::size_t index, std::size_t level, Job& job);
+    void finishJob();
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "CowHashMap.hpp"
+#include "CowSet.hpp"
+#include "CowVector.hpp"
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Index of busy time used for free-slot search.
+//
+// Every busy interval is stored under a caller supplied key so it can be
+// erased again later. Overlapping intervals are merged into disjoint
+// "blocks" which live in a treap ordered by start time. Each treap node
+// also knows the largest gap between neighbouring blocks in its subtree,
+// which lets findFirstFit() jump straight to the first gap that is long
+// enough instead of probing the timeline step by step.
+//
+// Everything is held in copy-on-write containers, so copying an index is
+// O(1) and the first change after a copy clones only the pages it touches:
+// the treap path of the block, one shard and one page of the raw intervals.
+class IntervalIndex {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+    using Duration = TimePoint::duration;
+    using Key = std::uint64_t;
+
+    struct Item {
+        Key key;
+        TimePoint start;
+        TimePoint end;
+    };
+
+    IntervalIndex();
+
+    // Interval management. The bulk insert merges everything into the
+    // existing blocks and rebuilds the treap once, in O(n log n) overall.
+    void insert(Key key, const TimePoint& start, const TimePoint& end);
+    void insert(std::vector<Item> items);
+    bool erase(Key key);
+    bool contains(Key key) const { return intervals_.count(key) != 0; }
+    void clear();
+    std::size_t size() const { return intervals_.size(); }
+
+    // Queries
+    bool isFree(const TimePoint& start, const TimePoint& end) const;
+    TimePoint findFirstFit(const TimePoint& from, const Duration& duration) const;
+    TimePoint end() const;   // everything from here on is free; min() when empty
+
+private:
+    struct Interval {
+        TimePoint start;
+        TimePoint end;
+    };
+
+    struct Node {
+        TimePoint start;
+        TimePoint end;
+        std::uint32_t priority;
+        int left = -1;
+        int right = -1;
+
+        // Subtree aggregates
+        TimePoint firstStart;
+        TimePoint lastEnd;
+        Duration maxGap;
+    };
+
+    // What the in-order walk in findGap() has seen just before a subtree
+    struct Prev {
+        bool valid = false;
+        TimePoint end;
+    };
+
+    // Raw intervals, needed to rebuild a block after one of its parts goes away
+    CowHashMap<Key, Interval> intervals_;
+    CowSet<std::pair<TimePoint, Key>> byStart_;
+
+    // Treap of disjoint blocks
+    CowVector<Node> nodes_;
+    CowVector<int> freeNodes_;
+    int root_ = -1;
+    std::uint32_t seed_;
+
+    // Block helpers
+    void addBlock(TimePoint start, TimePoint end);
+    void removeBlock(const TimePoint& start);
+    int findBlockAtOrBefore(const TimePoint& time) const;
+    int findBlockAfter(const TimePoint& time) const;
+    bool findGap(int node, const TimePoint& lo, const Duration& duration,
+                 Prev& prev, TimePoint& result) const;
+
+    // Treap primitives
+    int build(const std::vector<Interval>& blocks, std::size_t first, std::size_t last,
+              std::size_t depth, std::vector<std::size_t>& depths);
+    int newNode(const TimePoint& start, const TimePoint& end);
+    void pull(Node& n);
+    void split(int node, const TimePoint& key, int& left, int& right);
+    int merge(int left, int right);
+    std::uint32_t nextPriority();
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Interval tree over possibly overlapping [start, end) intervals.
+//
+// Intervals are kept in a treap ordered by (start, key) where every node
+// also stores the largest end time in its subtree. That is enough to
+// report all intervals overlapping a range in O(log n + k).
+class IntervalTree {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+    using Key = std::uint64_t;
+
+    IntervalTree();
+
+    // Interval management
+    void insert(Key key, const TimePoint& start, const TimePoint& end);
+    bool erase(Key key);
+    void clear();
+    std::size_t size() const { return index_.size(); }
+
+    // Queries
+    void overlapping(const TimePoint& from, const TimePoint& to, std::vector<Key>& out) const;
+
+private:
+    struct Node {
+        TimePoint start;
+        TimePoint end;
+        Key key;
+        std::uint32_t priority;
+        int left = -1;
+        int right = -1;
+        TimePoint maxEnd;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<int> freeNodes_;
+    std::unordered_map<Key, int> index_;
+    int root_ = -1;
+    std::uint32_t seed_;
+
+    void collect(int node, const TimePoint& from, const TimePoint& to, std::vector<Key>& out) const;
+
+    // Treap primitives, ordered by (start, key)
+    bool less(const TimePoint& start, Key key, int node) const;
+    void pull(int node);
+    void split(int node, const TimePoint& start, Key key, int& left, int& right);
+    int merge(int left, int right);
+    std::uint32_t nextPriority();
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "Priority.hpp"
+#include "Recurrence.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TaskScheduler;
+
+// Append-only log of TaskScheduler mutations, for durability between
+// snapshots.
+//
+// A journal directory holds numbered segments "journal-<N>.log" and
+// snapshots "snapshot-<N>", where snapshot-N is the state after every
+// segment below N. Each record is a length, a checksum and a type byte
+// followed by its fields; times are clock ticks and strings are length
+// prefixed, in native byte order like Snapshot.
+//
+// Appending only copies the record into a buffer. A writer thread does the
+// group commit: it takes everything appended since its last round, writes
+// it with a single write and fsync, and then marks it durable. Mutations
+// made while one fsync runs all go into the next. Callers that must not
+// acknowledge a change before it is on disk wait for its sequence number.
+//
+// compact() rolls over to a new segment and folds the closed ones into a
+// new snapshot on a background thread. It replays them onto the previous
+// snapshot rather than touching the live scheduler, so writers carry on
+// appending to the new segment meanwhile.
+class Journal {
+public:
+    using Sequence = std::uint64_t;
+
+    struct Options {
+        std::size_t segmentBytes = std::size_t(64) << 20;   // roll over past this size
+    };
+
+    // Opens `directory`, creating it if needed, and starts a new segment
+    // after any already there.
+    explicit Journal(const std::string& directory);
+    Journal(const std::string& directory, const Options& options);
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Rebuilds the scheduler from the newest snapshot and every segment
+    // after it, then attaches this journal to it. Replay stops at the first
+    // damaged record, which is normally a write torn by a crash. Replayed
+    // changes are placed by the next scheduling pass. Call before anything
+    // is appended or compacted.
+    std::unique_ptr<TaskScheduler> recover();
+
+    // Records, called by the attached TaskScheduler. Each returns the
+    // record's sequence number.
+    Sequence logAddTask(const std::string& name, const std::chrono::minutes& duration, Priority priority,
+                        const std::chrono::system_clock::time_point& deadline, bool completed);
+    Sequence logUpdateTask(const std::string& taskName, const std::string& name,
+                           const std::chrono::minutes& duration, Priority priority,
+                           const std::chrono::system_clock::time_point& deadline, bool completed);
+    Sequence logRemoveTask(const std::string& name);
+    Sequence logCompleteTask(const std::string& name);
+    Sequence logAddCalendarEvent(std::uint64_t id, const std::chrono::system_clock::time_point& start,
+                                 const std::chrono::system_clock::time_point& end,
+                                 const std::string& description, std::optional<std::size_t> lane);
+    Sequence logRemoveCalendarEvent(std::uint64_t id);
+    Sequence logAddRecurringEvent(std::uint64_t id, const std::chrono::system_clock::time_point& start,
+                                  const std::chrono::system_clock::time_point& end,
+                                  const std::string& description, const RecurrenceRule& rule,
+                                  std::optional<std::size_t> lane);
+    Sequence logAddDependency(const std::string& taskName, const std::string& prerequisiteName);
+    Sequence logRemoveDependency(const std::string& taskName, const std::string& prerequisiteName);
+    Sequence logAddRecurringTask(const std::string& name, const std::chrono::minutes& duration, Priority priority,
+                                 const std::chrono::system_clock::time_point& firstDue, const RecurrenceRule& rule);
+    Sequence logRemoveRecurringTask(const std::string& name);
+    Sequence logExpandRecurringTask(const std::string& name, const std::chrono::system_clock::time_point& until);
+    // Lane count, TaskScheduler::SchedulingPolicy, granularity and horizon,
+    // all of them whenever one changes
+    Sequence logSettings(std::size_t lanes, std::uint8_t policy, const std::chrono::minutes& granularity,
+                         const std::chrono::minutes& horizon);
+
+    // Group commit. waitDurable() blocks until the record is on disk and
+    // returns false if writing failed; sync() waits for everything so far.
+    Sequence lastSequence() const;
+    Sequence durableSequence() const { return durable_.load(); }
+    bool waitDurable(Sequence sequence);
+    bool sync();
+
+    // Background compaction. compact() returns false while a previous one
+    // is still running; waitForCompaction() tells whether the last one
+    // wrote its snapshot.
+    bool compact();
+    bool waitForCompaction();
+
+    // Replays one segment onto a scheduler with no journal attached.
+    // Returns false if it ended in a damaged record.
+    static bool replay(const std::string& path, TaskScheduler& scheduler);
+
+private:
+    std::string directory_;
+    Options options_;
+
+    // Appended records not yet handed to the writer thread
+    mutable std::mutex mutex_;
+    std::vector<char> pending_;
+    Sequence appended_ = 0;
+    bool rollRequested_ = false;
+    bool stopping_ = false;
+    bool failed_ = false;
+    std::condition_variable workAvailable_;
+    std::condition_variable committed_;
+
+    // Owned by the writer thread, except while it is not running
+    std::FILE* segment_ = nullptr;
+    std::uint64_t segmentNumber_ = 0;
+    std::size_t segmentSize_ = 0;
+    std::atomic<Sequence> durable_{0};
+    std::thread writer_;
+
+    // Only one of recover() and compaction folds segments at a time
+    std::mutex foldMutex_;
+    std::atomic<bool> compacting_{false};
+    bool compactionSucceeded_ = true;
+    std::thread compactor_;
+
+    std::string segmentPath(std::uint64_t number) const;
+    std::string snapshotPath(std::uint64_t number) const;
+    bool openSegment(std::uint64_t number);
+    Sequence append(const std::vector<char>& record);
+    void run();
+    std::unique_ptr<TaskScheduler> fold(std::uint64_t end);
+    bool compactBelow(std::uint64_t end);
+};
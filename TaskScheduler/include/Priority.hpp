@@ -0,0 +1,8 @@
+#pragma once
+
+enum class Priority {
+    LOW,
+    MEDIUM,
+    HIGH,
+    URGENT
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <vector>
+
+// How a calendar event or task repeats
+struct RecurrenceRule {
+    enum class Frequency {
+        DAILY,   // every `interval`-th day that is one of `weekdays`
+        WEEKLY   // on `weekdays` of every `interval`-th week
+    };
+
+    // Weekday bits run from Sunday (bit 0) to Saturday (bit 6). Zero means
+    // every day for DAILY and the weekday of `first` for WEEKLY.
+    Frequency frequency = Frequency::DAILY;
+    unsigned interval = 1;
+    std::uint8_t weekdays = 0;
+    std::chrono::system_clock::time_point until = std::chrono::system_clock::time_point::max();
+    std::set<std::chrono::system_clock::time_point> exceptions;   // starts of skipped occurrences
+};
+
+// Occurrences [start, start + length) of a rule, computed on demand.
+//
+// Occurrences start whole days after the first one, so weeks and weekdays
+// are counted in UTC and a series keeps its UTC time of day across DST
+// changes. Nothing is materialized: a query costs a few divisions plus one
+// step per skipped day or exception.
+class Recurrence {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+    using Duration = TimePoint::duration;
+
+    Recurrence(const TimePoint& first, const Duration& length, RecurrenceRule rule);
+
+    const TimePoint& first() const { return first_; }
+    Duration length() const { return length_; }
+    const RecurrenceRule& rule() const { return rule_; }
+
+    // Queries
+    std::optional<TimePoint> firstEndingAfter(const TimePoint& time) const;
+    std::optional<TimePoint> firstStartingAt(const TimePoint& time) const;
+    void overlapping(const TimePoint& from, const TimePoint& to, std::vector<TimePoint>& starts) const;
+
+private:
+    TimePoint first_;
+    Duration length_;
+    RecurrenceRule rule_;
+    int firstWeekday_;
+
+    std::int64_t firstDayEndingAfter(const TimePoint& time) const;
+    std::optional<std::int64_t> occurrenceFrom(std::int64_t day) const;
+    TimePoint startOf(std::int64_t day) const;
+};
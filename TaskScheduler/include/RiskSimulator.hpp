@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Monte Carlo risk analysis of a fixed plan with uncertain durations.
+//
+// Each pass draws every job's duration from its triangular distribution and
+// propagates finish times in job order: a job starts at its planned start
+// or when the last of its predecessors finishes, whichever is later. Jobs
+// must come in topological order, predecessors first.
+//
+// Random numbers are counter based: the draw for job j in pass p is a
+// splitmix64 hash of (seed, p, j). Passes need no generator state, and the
+// results do not depend on how the passes are split over threads.
+class RiskSimulator {
+public:
+    // Times in minutes from a common base
+    struct Job {
+        double earliestStart;
+        double due;
+        double low;      // triangular duration: minimum, mode, maximum
+        double mode;
+        double high;
+    };
+
+    // Per worker state, allocated once and reused by every pass it runs
+    struct Tally {
+        std::vector<double> finish;
+        std::vector<std::uint32_t> misses;
+    };
+
+    struct Stats {
+        double missProbability = 0;
+        double p50Finish = 0;
+        double p90Finish = 0;
+    };
+    struct Result {
+        std::vector<Stats> jobs;
+        double p50Finish = 0;    // of the last job to finish
+        double p90Finish = 0;
+    };
+
+    // predecessors[j] lists jobs before j that j waits for
+    RiskSimulator(const std::vector<Job>& jobs, const std::vector<std::vector<std::uint32_t>>& predecessors);
+
+    std::size_t size() const { return earliest_.size(); }
+    Tally makeTally() const;
+
+    // Runs passes [first, last). Passes below `sampleCount` also store their
+    // finish times as row `pass` of `samples` (sampleCount x size() floats),
+    // which the percentiles are taken from; misses count every pass. With
+    // no samples, summarize leaves the percentiles at 0.
+    void run(std::uint64_t first, std::uint64_t last, std::uint64_t seed, Tally& tally,
+             float* samples, std::uint64_t sampleCount) const;
+
+    Result summarize(const std::vector<Tally>& tallies, std::uint64_t passes,
+                     const std::vector<float>& samples, std::uint64_t sampleCount) const;
+
+private:
+    // Struct of arrays, walked front to back by every pass
+    std::vector<double> earliest_;
+    std::vector<double> due_;
+    std::vector<double> low_;
+    std::vector<double> high_;
+    std::vector<double> split_;     // probability of drawing below the mode
+    std::vector<double> lowArea_;   // (high - low) * (mode - low)
+    std::vector<double> highArea_;  // (high - low) * (high - mode)
+    std::vector<std::uint32_t> firstPredecessor_;   // size() + 1 offsets into predecessors_
+    std::vector<std::uint32_t> predecessors_;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Simulated annealing over the order of jobs run back to back on one lane,
+// minimising total weighted tardiness.
+//
+// Moves swap two neighbours in the sequence. Only those two completion
+// times change, so every move is evaluated in O(1) from a prefix array of
+// completion times and millions of moves per second are possible.
+class SequenceOptimizer {
+public:
+    // Durations and due times in minutes, relative to the lane start
+    struct Job {
+        std::int64_t duration;
+        std::int64_t due;
+        std::int64_t weight;
+    };
+
+    struct Result {
+        std::vector<std::uint32_t> order;
+        std::int64_t cost = 0;
+        std::uint64_t moves = 0;
+    };
+
+    explicit SequenceOptimizer(std::vector<Job> jobs);
+
+    std::int64_t cost(const std::vector<std::uint32_t>& order) const;
+
+    // Order by due time (EDD), a strong start for tardiness problems
+    std::vector<std::uint32_t> dueOrder() const;
+
+    // Anneals from `order` for `budget`; different seeds give independent runs
+    Result anneal(std::vector<std::uint32_t> order, std::chrono::nanoseconds budget, std::uint64_t seed) const;
+
+private:
+    std::vector<Job> jobs_;
+
+    std::int64_t tardiness(std::uint32_t job, std::int64_t completion) const {
+        auto late = completion - jobs_[job].due;
+        return late > 0 ? late * jobs_[job].weight : 0;
+    }
+};
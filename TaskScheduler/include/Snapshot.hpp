@@ -0,0 +1,223 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Versioned binary image of a TaskScheduler, written by
+// TaskScheduler::saveSnapshot() and read through a read-only memory map.
+//
+// A file is a fixed header followed by 8-byte aligned sections. Every
+// section is a flat array of one fixed-size type, and the task sections
+// use TaskStore's struct-of-arrays layout indexed by handle, so loading
+// copies whole columns instead of parsing records. Times are clock ticks
+// since the epoch and durations are minutes, both as int64. Values are in
+// native byte order: open() refuses files from a machine with another byte
+// order or clock resolution.
+class Snapshot {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+
+    enum class Section : std::uint32_t {
+        TASK_NAME_OFFSETS,  // uint64 per handle plus one end offset, into TASK_NAMES
+        TASK_NAMES,         // char
+        DURATIONS,          // int64 minutes per handle
+        PRIORITIES,         // uint8 per handle
+        DEADLINES,          // int64 ticks per handle
+        SCHEDULED_TIMES,    // int64 ticks per handle
+        COMPLETED,          // uint64 words, one bit per handle
+        LIVE,               // uint8 per handle
+        PLACEMENTS,         // Placement per handle
+        BUCKETS,            // uint32 handles in scheduling order, LOW bucket first
+        EVENTS,             // EventRecord
+        SERIES,             // SeriesRecord
+        TEXT,               // char, event descriptions and series names
+        EXCEPTIONS,         // int64 ticks, skipped occurrences of rules
+        PREREQUISITES,      // Edge per prerequisite, grouped by task
+        DEPENDENTS,         // Edge per dependent, grouped by task
+        TIMINGS,            // Timing per handle, or none
+        CRITICAL_PATH,      // uint32 handles
+        COUNT
+    };
+    static constexpr std::size_t kSectionCount = static_cast<std::size_t>(Section::COUNT);
+
+    struct SectionEntry {
+        std::uint64_t offset;
+        std::uint64_t count;
+        std::uint32_t elementSize;
+        std::uint32_t reserved;
+    };
+
+    // Scheduler settings and bookkeeping live in the header
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint64_t ticksPerSecond;
+        std::uint64_t fileSize;
+        std::uint64_t checksum;      // of the whole file with this field zero
+        std::uint64_t taskCapacity;
+        std::uint64_t bucketSizes[4];
+        std::uint64_t nextEventId;
+        std::uint32_t laneCount;
+        std::uint32_t policy;
+        std::int64_t granularity;
+        std::int64_t horizon;
+        std::int64_t horizonEnd;
+        std::int64_t utcOffset;
+        std::uint8_t hasUtcOffset;
+        std::uint8_t hasDirty;
+        std::uint8_t hasFrontier;
+        std::uint8_t dependencyCycle;
+        std::uint32_t reserved;
+        std::uint64_t dirty[2];      // bucket, index
+        std::uint64_t frontier[2];
+        SectionEntry sections[kSectionCount];
+    };
+
+    // Per handle scheduler state
+    enum PlacementFlags : std::uint8_t {
+        PLACED = 1,
+        DEFERRED = 2,
+        DEADLINE_INDEXED = 4
+    };
+    struct Placement {
+        std::int64_t placedAt;       // slot held on the lane, ticks
+        std::uint32_t lane;
+        std::uint8_t flags;
+        std::uint8_t reserved[3];
+    };
+
+    // A recurrence rule; its exceptions are EXCEPTIONS[firstException, + exceptionCount)
+    struct RuleRecord {
+        std::int64_t until;
+        std::uint64_t firstException;
+        std::uint64_t exceptionCount;
+        std::uint32_t interval;
+        std::uint8_t frequency;
+        std::uint8_t weekdays;
+        std::uint8_t reserved[2];
+    };
+
+    static constexpr std::uint32_t kNoLane = ~std::uint32_t(0);
+    struct EventRecord {
+        std::uint64_t id;
+        std::int64_t start;
+        std::int64_t end;
+        std::uint64_t textOffset;
+        std::uint64_t textLength;
+        std::uint32_t lane;          // kNoLane when it blocks every lane
+        std::uint8_t recurring;
+        std::uint8_t reserved[3];
+        RuleRecord rule;
+    };
+
+    struct SeriesRecord {
+        std::uint64_t textOffset;
+        std::uint64_t textLength;
+        std::int64_t firstDue;
+        std::int64_t expandedUntil;
+        std::int64_t duration;
+        std::uint8_t priority;
+        std::uint8_t reserved[7];
+        RuleRecord rule;
+    };
+
+    struct Edge {
+        std::uint32_t task;
+        std::uint32_t other;
+    };
+
+    struct Timing {
+        std::int64_t earliestStart;
+        std::int64_t latestStart;
+    };
+
+    // View of one section, valid while the Snapshot lives
+    template <typename T>
+    class Column {
+    public:
+        Column() = default;
+        Column(const T* data, std::size_t size) : data_(data), size_(size) {}
+
+        const T* begin() const { return data_; }
+        const T* end() const { return data_ + size_; }
+        const T* data() const { return data_; }
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const T& operator[](std::size_t i) const { return data_[i]; }
+
+    private:
+        const T* data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+
+    // Maps the file and checks its checksum, header and section bounds.
+    // Returns null if the file is missing, damaged or not a snapshot of
+    // this version.
+    static std::unique_ptr<Snapshot> open(const std::string& path);
+    ~Snapshot();
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    const Header& header() const { return *reinterpret_cast<const Header*>(data_); }
+
+    // Empty if T does not match the section's element size
+    template <typename T>
+    Column<T> column(Section section) const {
+        const auto& entry = header().sections[static_cast<std::size_t>(section)];
+        if (entry.elementSize != sizeof(T)) {
+            return {};
+        }
+        return Column<T>(reinterpret_cast<const T*>(data_ + entry.offset), static_cast<std::size_t>(entry.count));
+    }
+
+    static std::uint32_t elementSize(Section section);
+
+private:
+    Snapshot() = default;
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+#ifdef _WIN32
+    std::vector<std::uint64_t> buffer_;   // no mapping, the file is read instead
+#endif
+};
+
+// Collects sections and writes them as one snapshot file. The file is
+// written next to `path`, synced and then renamed over it, so readers see
+// either the old snapshot or the complete new one.
+class SnapshotWriter {
+public:
+    SnapshotWriter();
+
+    Snapshot::Header& header() { return header_; }
+
+    // Borrowed data must stay alive until write()
+    template <typename T>
+    void add(Snapshot::Section section, const T* data, std::size_t count) {
+        sections_[static_cast<std::size_t>(section)] = Pending{data, count, sizeof(T)};
+    }
+    template <typename T>
+    void add(Snapshot::Section section, std::vector<T> data) {
+        auto owned = std::make_shared<std::vector<T>>(std::move(data));
+        owned_.push_back(owned);
+        add(section, owned->data(), owned->size());
+    }
+
+    bool write(const std::string& path);
+
+private:
+    struct Pending {
+        const void* data = nullptr;
+        std::size_t count = 0;
+        std::size_t elementSize = 0;
+    };
+
+    Snapshot::Header header_;
+    std::array<Pending, Snapshot::kSectionCount> sections_;
+    std::vector<std::shared_ptr<const void>> owned_;
+};
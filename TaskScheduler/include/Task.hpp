@@ -1,41 +1,56 @@
 #pragma once
 
+#include "Priority.hpp"
+#include "TaskStore.hpp"
 #include <string>
+#include <functional>
 #include <chrono>
 #include <ctime>
 
-enum class Priority {
-    LOW,
-    MEDIUM,
-    HIGH,
-    URGENT
-};
-
+// A task either stands on its own or is bound to a slot of a TaskStore
+// while a TaskScheduler owns it. Bound tasks read and write their fields
+// through the store, so the scheduler and the Task always agree. A task
+// can belong to one scheduler at a time.
 class Task {
 public:
-    Task(const std::string& name, 
+    Task(const std::string& name,
          const std::chrono::minutes& duration,
          Priority priority,
          const std::chrono::system_clock::time_point& deadline);
 
     // Getters
-    const std::string& getName() const { return name_; }
-    std::chrono::minutes getDuration() const { return duration_; }
-    Priority getPriority() const { return priority_; }
-    std::chrono::system_clock::time_point getDeadline() const { return deadline_; }
-    bool isCompleted() const { return completed_; }
-    std::chrono::system_clock::time_point getScheduledTime() const { return scheduled_time_; }
+    const std::string& getName() const { return store_ ? store_->name(handle_) : name_; }
+    std::chrono::minutes getDuration() const { return store_ ? store_->duration(handle_) : duration_; }
+    Priority getPriority() const { return store_ ? store_->priority(handle_) : priority_; }
+    std::chrono::system_clock::time_point getDeadline() const {
+        return store_ ? store_->deadline(handle_) : deadline_;
+    }
+    bool isCompleted() const { return store_ ? store_->isCompleted(handle_) : completed_; }
+    std::chrono::system_clock::time_point getScheduledTime() const {
+        return store_ ? store_->scheduledTime(handle_) : scheduled_time_;
+    }
+    const std::function<void()>& getPayload() const { return store_ ? store_->payload(handle_) : payload_; }
 
     // Setters
-    void setScheduledTime(const std::chrono::system_clock::time_point& time) { scheduled_time_ = time; }
-    void setCompleted(bool completed) { completed_ = completed; }
-    void setPriority(Priority priority) { priority_ = priority; }
+    void setScheduledTime(const std::chrono::system_clock::time_point& time);
+    void setCompleted(bool completed);
+    void setPriority(Priority priority);
+    void setPayload(std::function<void()> payload);
 
 private:
+    friend class TaskStore;
+
     std::string name_;
     std::chrono::minutes duration_;
     Priority priority_;
     std::chrono::system_clock::time_point deadline_;
     bool completed_ = false;
     std::chrono::system_clock::time_point scheduled_time_;
-}; 
\ No newline at end of file
+    std::function<void()> payload_;
+
+    // Store slot while bound
+    TaskStore* store_ = nullptr;
+    TaskStore::Handle handle_ = TaskStore::kInvalidHandle;
+
+    void detach();
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "TaskStore.hpp"
+#include "TimingWheel.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Start and deadline notifications for tasks, on a dedicated thread.
+//
+// Each task has at most one timer per event in a TimingWheel whose tick is
+// the resolution, so arming and cancelling are O(1). Events fire at the
+// first tick at or after their time, never early. The thread sleeps until
+// the wheel's next expiry and is woken only when an earlier timer is armed.
+// Callbacks run on that thread outside the lock, in expiry order; events
+// armed for a time already past come first.
+//
+// An event is not repeated for the time it already fired for, so a task
+// re-placed into the slot it started in is not announced twice.
+class TaskNotifier {
+public:
+    using Handle = TaskStore::Handle;
+    enum class Event { START, DEADLINE };
+    using Callback = std::function<void(Handle, Event)>;
+
+    TaskNotifier(Callback callback, std::chrono::milliseconds resolution);
+    ~TaskNotifier();
+    TaskNotifier(const TaskNotifier&) = delete;
+    TaskNotifier& operator=(const TaskNotifier&) = delete;
+
+    // Replaces the handle's timer for `event`
+    void arm(Handle handle, Event event, const std::chrono::system_clock::time_point& time);
+    void cancel(Handle handle, Event event);
+    // Cancels both timers of a handle that is about to be reused
+    void forget(Handle handle);
+    std::size_t size() const;
+
+private:
+    // Timers and the last fired tick per handle and event
+    struct Timers {
+        TimingWheel::TimerId armed[2] = {0, 0};
+        TimingWheel::Tick fired[2] = {kNever, kNever};
+    };
+    static constexpr TimingWheel::Tick kNever = std::numeric_limits<TimingWheel::Tick>::min();
+
+    Callback callback_;
+    std::chrono::system_clock::duration resolution_;
+
+    mutable std::mutex mutex_;
+    TimingWheel wheel_;
+    std::vector<Timers> timers_;
+    TimingWheel::Tick wakeAt_ = kNever;    // tick the thread sleeps until, kNever while awake
+    bool stopping_ = false;
+    std::condition_variable wake_;
+    std::thread thread_;
+
+    TimingWheel::Tick floorTick(const std::chrono::system_clock::time_point& time) const;
+    TimingWheel::Tick ceilTick(const std::chrono::system_clock::time_point& time) const;
+    void run();
+};
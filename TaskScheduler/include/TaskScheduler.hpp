@@ -1,44 +1,537 @@
 #pragma once
 
 #include "Task.hpp"
+#include "TaskStore.hpp"
+#include "CowHashMap.hpp"
+#include "CowPtr.hpp"
+#include "CowSet.hpp"
+#include "CowVector.hpp"
+#include "IntervalIndex.hpp"
+#include "BitmapTimeline.hpp"
+#include "EventStore.hpp"
+#include "TaskView.hpp"
+#include "Executor.hpp"
+#include "SequenceOptimizer.hpp"
+#include "RiskSimulator.hpp"
+#include "Snapshot.hpp"
+#include "Journal.hpp"
+#include "TaskNotifier.hpp"
+#include <array>
 #include <vector>
 #include <memory>
 #include <map>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
 #include <chrono>
+#include <functional>
+#include <mutex>
 
+// Task names are unique within a scheduler: adding a task whose name is
+// already present replaces the existing one.
+//
+// Task data lives in a struct-of-arrays TaskStore. The shared_ptr<Task>
+// API below is a compatibility layer over it; the handle based API works
+// on the store directly and never needs a Task object. Queries returning
+// Task objects create them on first use, so even the const ones must not
+// run concurrently; concurrent readers use handles and getTaskStore().
 class TaskScheduler {
 public:
+    using TaskHandle = TaskStore::Handle;
+    using Notification = TaskNotifier::Event;
+
+    // Order in which a scheduling pass hands out time slots
+    enum class SchedulingPolicy {
+        PRIORITY,           // by priority, then insertion order
+        EARLIEST_DEADLINE,  // EDF: earliest deadline first
+        WEIGHTED_LATENESS   // Smith's rule: shortest duration per priority weight first
+    };
+
+    // Deadline misses of the current plan
+    struct LateTask {
+        std::shared_ptr<Task> task;
+        std::chrono::minutes lateness;
+    };
+    struct FeasibilityReport {
+        bool feasible = true;
+        std::chrono::minutes maxLateness{0};
+        std::chrono::minutes weightedLateness{0};  // sum over late tasks of lateness times weight
+        std::vector<LateTask> lateTasks;           // by deadline
+    };
+
+    // Local search stage run after the greedy placement
+    struct OptimizerOptions {
+        std::chrono::milliseconds timeBudget{100};
+        std::size_t restarts = 0;   // runs per lane, 0 for one per executor thread
+        std::uint64_t seed = 1;
+    };
+    struct OptimizerResult {
+        std::chrono::minutes weightedTardinessBefore{0};
+        std::chrono::minutes weightedTardinessAfter{0};
+        std::uint64_t moves = 0;
+        bool improved = false;
+    };
+
+    // Three point duration estimate, simulated as a triangular distribution
+    struct DurationEstimate {
+        std::chrono::minutes optimistic{0};
+        std::chrono::minutes likely{0};
+        std::chrono::minutes pessimistic{0};
+    };
+    struct RiskOptions {
+        std::size_t iterations = 10000;
+        std::size_t samples = 1024;   // passes whose finish times give the percentiles; 0 skips them
+        std::uint64_t seed = 1;
+    };
+    struct TaskRisk {
+        std::shared_ptr<Task> task;
+        double missProbability = 0;
+        std::chrono::system_clock::time_point p50Finish;
+        std::chrono::system_clock::time_point p90Finish;
+    };
+    struct RiskReport {
+        std::size_t iterations = 0;
+        std::vector<TaskRisk> tasks;   // by planned start
+        std::chrono::system_clock::time_point p50Finish;   // of the whole plan
+        std::chrono::system_clock::time_point p90Finish;
+    };
+
     TaskScheduler();
+    
+    // O(1) copy for what-if evaluation. The fork shares all task, calendar
+    // and schedule state with this scheduler; whichever side writes to a
+    // part of it first gets its own copy of just that part; per-task state
+    // is paged, so that is a page or a shard rather than every task. Task
+    // objects and the completion callback are not carried over, and tasks
+    // in flight on an executor stay marked as dispatched. Forking only
+    // reads, so several threads may fork one scheduler while nobody
+    // modifies it.
+    std::unique_ptr<TaskScheduler> fork() const;
+    
+    // Binary snapshots (see Snapshot) of tasks, calendar events, recurrence
+    // rules, dependencies, settings and the current plan. saveSnapshot()
+    // replaces the file atomically. loadSnapshot() maps it and rebuilds the
+    // scheduler without a scheduling pass, so every task keeps its slot and
+    // handles and event ids stay the same. Payloads, Task objects, the
+    // completion callback and dispatches in flight are not saved. Returns
+    // null if the file is missing or not a valid snapshot.
+    bool saveSnapshot(const std::string& path) const;
+    static std::unique_ptr<TaskScheduler> loadSnapshot(const std::string& path);
+    
+    // Mutation journal (see Journal). While one is attached, addTask,
+    // updateTask, removeTask, completeTask (including completions reported
+    // by an executor or made through Task::setCompleted), priority changes,
+    // calendar events and recurring events, dependencies, recurring tasks
+    // and the lane count, granularity, policy and horizon are appended to
+    // it, events dropped with their lane included. The UTC offset, duration
+    // estimates and changes made through other Task setters are not
+    // journaled. Events are logged with their ids, and replay hands them out
+    // again through skipEventIds(), so removals by id still find their
+    // event. Recurring task occurrences are logged as tasks, and replay
+    // moves their series past them through skipRecurringTask() so they are
+    // not created twice. The journal must outlive the scheduler; forks and
+    // loaded snapshots start without one.
+    void setJournal(Journal* journal) { journal_ = journal; }
+    Journal* getJournal() const { return journal_; }
+    void skipEventIds(EventStore::Id next) { calendar_events_->skipIds(next); }
+    void skipRecurringTask(const std::string& name, const std::chrono::system_clock::time_point& until);
 
     // Task Management
     void addTask(std::shared_ptr<Task> task);
+    void addTasks(const std::vector<std::shared_ptr<Task>>& tasks);
+    template <typename ForwardIt>
+    void addTasks(ForwardIt first, ForwardIt last);
     void removeTask(const std::string& taskName);
     void updateTask(const std::string& taskName, std::shared_ptr<Task> newTask);
+    std::shared_ptr<Task> getTask(const std::string& taskName) const;
+    std::size_t getTaskCount() const { return nameIndex_.size(); }
+    
+    void completeTask(const std::string& taskName);
     
-    // Scheduling
+    // Handle based task management
+    TaskHandle addTask(const std::string& name, const std::chrono::minutes& duration,
+                       Priority priority, const std::chrono::system_clock::time_point& deadline);
+    void removeTask(TaskHandle handle);
+    void completeTask(TaskHandle handle);
+    TaskHandle findTask(const std::string& taskName) const;
+    std::shared_ptr<Task> getTask(TaskHandle handle) const;
+    // Copy of a priority bucket in scheduling order; getTasksByPriority()
+    // views it without copying
+    std::vector<TaskHandle> getTaskHandlesByPriority(Priority priority) const;
+    
+    // Moves a task to the end of its new priority's bucket in amortized
+    // O(1), keeping the order of the others, and invalidates the slots from
+    // its old place on, so priority bumps and aging do not wait for an
+    // update to take effect. Setting the priority a task already has
+    // changes nothing. Task::setPriority on a task of this scheduler comes
+    // here too.
+    bool changePriority(const std::string& taskName, Priority priority);
+    bool changePriority(TaskHandle handle, Priority priority);
+    const TaskStore& getTaskStore() const { return *store_; }
+    
+    // Scheduling. scheduleTasks() places every task from scratch, while
+    // rescheduleTasks() only reflows from the first task whose slot was
+    // invalidated since the last pass and leaves earlier placements alone.
     void scheduleTasks();
     void rescheduleTasks();
     
-    // Queries
-    std::vector<std::shared_ptr<Task>> getTasksByPriority(Priority priority) const;
+    // Scheduling horizon. With a non-zero horizon a pass stops handing out
+    // slots at the first task that would start after now + horizon; it and
+    // every task after it in scheduling order wait in an unplaced backlog,
+    // and reflows never touch them. rescheduleTasks() moves the window along
+    // as time passes, extendHorizon() places the backlog up to `until` for
+    // queries that look further ahead. Day views, dispatch and the
+    // optimizer only see placed tasks. Zero (the default) places everything.
+    void setSchedulingHorizon(const std::chrono::minutes& horizon);
+    std::chrono::minutes getSchedulingHorizon() const { return horizon_; }
+    void extendHorizon(const std::chrono::system_clock::time_point& until);
+    std::chrono::system_clock::time_point getHorizonEnd() const { return horizonEnd_; }
+    
+    // Any policy but PRIORITY, like any dependency edge, turns every
+    // scheduling pass into a full heap based list scheduling pass. Priority
+    // weights are 1, 2, 4 and 8 from LOW to URGENT.
+    void setSchedulingPolicy(SchedulingPolicy policy);
+    SchedulingPolicy getSchedulingPolicy() const { return policy_; }
+    
+    // Deadline check of the plan made by the last scheduling pass, so it can
+    // run before any work starts. admitTask() only adds a task whose name is
+    // new and which makes no task late that was on time, nor any late task
+    // later. The check runs on a fork, so a rejected task is never added,
+    // journaled or placed here.
+    FeasibilityReport getFeasibilityReport() const;
+    bool admitTask(std::shared_ptr<Task> task);
+    
+    // Improves the current plan's total weighted tardiness by reordering
+    // the tasks of each lane with simulated annealing. Independent runs per
+    // lane execute on the executor and the best order wins; it is placed
+    // through the calendar again and only kept if the real plan improved.
+    // The new order lasts until a scheduling pass reflows those tasks.
+    // Plans with dependencies are left alone.
+    OptimizerResult optimizeSchedule(Executor& executor);
+    OptimizerResult optimizeSchedule(Executor& executor, const OptimizerOptions& options);
+    
+    // Schedule risk. A task with an estimate gets a random duration in each
+    // simulated pass, the others keep their fixed one. Passes run in chunks
+    // on the executor and keep the current plan's lanes and order: a task
+    // starts at its planned start or once its lane predecessor and pending
+    // prerequisites finish, whichever is later. Calendar events are not
+    // searched again for slipped tasks. Only placed pending tasks take part.
+    // Estimates are dropped when their task is updated or removed, and are
+    // not part of snapshots. Without samples, or without iterations, the
+    // percentile finishes are left default constructed.
+    bool setDurationEstimate(const std::string& taskName, const DurationEstimate& estimate);
+    bool setDurationEstimate(TaskHandle handle, const DurationEstimate& estimate);
+    RiskReport simulateRisk(Executor& executor);
+    RiskReport simulateRisk(Executor& executor, const RiskOptions& options);
+    
+    // Parallel lanes (workers, machines, rooms). Tasks are list scheduled:
+    // in scheduling order, each task goes to the lane that frees up first.
+    // Calendar events block every lane unless they are added for one lane;
+    // adding one for a lane that does not exist fails with
+    // EventStore::kInvalidId. Changing the lane count drops the events of
+    // removed lanes and invalidates the whole schedule.
+    void setLaneCount(std::size_t lanes);
+    std::size_t getLaneCount() const { return lanes_->size(); }
+    std::optional<std::size_t> getTaskLane(TaskHandle handle) const;
+    
+    // Busy time representation of every lane. A zero granularity (the
+    // default) keeps busy time exact in an interval index. Any other value
+    // switches to bitmap timelines with one bit per quantum: tasks then
+    // start on quantum boundaries and busy time is rounded out to whole
+    // quanta, which makes slot search on dense multi-month calendars a
+    // matter of scanning words. Changing it invalidates the whole schedule.
+    void setTimeGranularity(const std::chrono::minutes& granularity);
+    std::chrono::minutes getTimeGranularity() const { return granularity_; }
+    
+    // Dependencies. A task is never placed before all of its pending
+    // prerequisites end; completed prerequisites no longer hold it back.
+    // Unknown tasks, self edges and duplicate edges are refused. While any
+    // edge exists, every scheduling pass is a full critical-path aware list
+    // scheduling pass: among the tasks whose prerequisites are placed, the
+    // highest priority goes first, then the one with the least slack.
+    // Tasks on a dependency cycle, and everything depending on them, are
+    // left unplaced.
+    bool addDependency(const std::string& taskName, const std::string& prerequisiteName);
+    bool removeDependency(const std::string& taskName, const std::string& prerequisiteName);
+    bool addDependency(TaskHandle task, TaskHandle prerequisite);
+    bool removeDependency(TaskHandle task, TaskHandle prerequisite);
+    std::size_t getDependencyCount() const { return dependencyCount_; }
+    bool hasDependencyCycle() const { return dependencyCycle_; }
+    
+    // Critical path method results of the last scheduling pass, from task
+    // durations alone: offsets from the start of the plan, as if every lane
+    // and calendar slot were available.
+    struct TaskTiming {
+        std::chrono::minutes earliestStart{0};
+        std::chrono::minutes latestStart{0};
+        std::chrono::minutes slack() const { return latestStart - earliestStart; }
+    };
+    std::optional<TaskTiming> getTaskTiming(TaskHandle handle) const;
+    std::vector<std::shared_ptr<Task>> getCriticalPath() const;
+    
+    // Queries. getTasksByPriority() returns a view of the priority bucket in
+    // scheduling order; tasks are filed under their current priority.
+    TaskView getTasksByPriority(Priority priority) const;
+    
+    // Calendar day views. A day runs from local midnight to local midnight
+    // (DST aware) unless a fixed UTC offset is set; results are ordered by
+    // scheduled time.
     std::vector<std::shared_ptr<Task>> getTasksByDate(const std::chrono::system_clock::time_point& date) const;
+    std::vector<std::shared_ptr<Task>> getTasksByDateRange(const std::chrono::system_clock::time_point& firstDate,
+                                                           int days) const;
+    std::vector<std::shared_ptr<Task>> getTasksByWeek(const std::chrono::system_clock::time_point& firstDate) const;
+    void setUtcOffset(const std::chrono::minutes& offset) { utcOffset_ = offset; }
+    void useLocalTime() { utcOffset_.reset(); }
     std::vector<std::shared_ptr<Task>> getOverdueTasks() const;
     
+    // Pending task with the earliest deadline that has not passed yet (or is
+    // not before `after`), so callers can sleep until exactly that deadline.
+    std::shared_ptr<Task> getNextDeadlineTask() const;
+    std::shared_ptr<Task> getNextDeadlineTask(const std::chrono::system_clock::time_point& after) const;
+    
+    // Execution. dispatchTasks() hands every pending task with a payload
+    // whose scheduled start lies before `until` to the executor, in start
+    // time order. Workers only report back; processCompletions() then
+    // marks the finished tasks completed, reschedules, and runs the
+    // completion callback for each of them on the calling thread. A task is
+    // never dispatched twice while it runs. The executor must be drained
+    // before the scheduler is destroyed.
+    std::size_t dispatchTasks(Executor& executor,
+                              const std::chrono::system_clock::time_point& until =
+                                  std::chrono::system_clock::time_point::max());
+    std::size_t processCompletions();
+    void setCompletionCallback(std::function<void(const std::shared_ptr<Task>&)> callback) {
+        completionCallback_ = std::move(callback);
+    }
+    
+    // Start and deadline notifications (see TaskNotifier). While they are
+    // on, every placed task has a timer for its scheduled start and every
+    // pending task one for its deadline; placing, releasing, completing and
+    // removing a task re-arms or cancels them in O(1). The callback runs on
+    // the notifier's thread and must not call into the scheduler without
+    // synchronisation of its own, and a handle may be stale by the time it
+    // arrives. Forks and loaded snapshots start without notifications.
+    void startNotifications(std::function<void(TaskHandle, Notification)> callback,
+                            std::chrono::milliseconds resolution = std::chrono::seconds(1));
+    void stopNotifications() { notifier_.reset(); }
+    
     // Calendar Management
-    void addCalendarEvent(const std::chrono::system_clock::time_point& start,
-                         const std::chrono::system_clock::time_point& end,
-                         const std::string& description);
+    EventStore::Id addCalendarEvent(const std::chrono::system_clock::time_point& start,
+                                    const std::chrono::system_clock::time_point& end,
+                                    const std::string& description);
+    EventStore::Id addCalendarEvent(const std::chrono::system_clock::time_point& start,
+                                    const std::chrono::system_clock::time_point& end,
+                                    const std::string& description, std::size_t lane);
     void removeCalendarEvent(const std::string& description);
+    bool removeCalendarEvent(EventStore::Id id);
+    std::vector<CalendarEvent> getCalendarEvents(const std::chrono::system_clock::time_point& from,
+                                                 const std::chrono::system_clock::time_point& to) const;
+    
+    // Recurring events are stored once, as a rule, and expanded only inside
+    // slot searches and getCalendarEvents(), so memory grows with the number
+    // of rules rather than occurrences. They are removed like single events;
+    // the id stands for the whole series. A task that fits between no
+    // occurrences is left unplaced: slot searches give up once the rules
+    // have repeated without a fit.
+    EventStore::Id addRecurringEvent(const std::chrono::system_clock::time_point& start,
+                                     const std::chrono::system_clock::time_point& end,
+                                     const std::string& description, const RecurrenceRule& rule);
+    EventStore::Id addRecurringEvent(const std::chrono::system_clock::time_point& start,
+                                     const std::chrono::system_clock::time_point& end,
+                                     const std::string& description, const RecurrenceRule& rule,
+                                     std::size_t lane);
+    
+    // Recurring tasks. Each occurrence becomes an ordinary task named
+    // "<name>@<UTC date>", due at the occurrence, once it falls due within
+    // the scheduling horizon (four weeks ahead without one). Removing a
+    // series keeps the occurrences created so far.
+    bool addRecurringTask(const std::string& name, const std::chrono::minutes& duration, Priority priority,
+                          const std::chrono::system_clock::time_point& firstDue, const RecurrenceRule& rule);
+    bool removeRecurringTask(const std::string& name);
 
 private:
-    std::vector<std::shared_ptr<Task>> tasks_;
-    std::map<std::chrono::system_clock::time_point, std::string> calendar_events_;
+    static constexpr std::size_t kPriorityCount = 4;
+
+    // Scheduler bookkeeping per task handle
+    struct Entry {
+        Priority bucket;              // priority the task is filed under
+        std::size_t position;         // index inside buckets_[bucket]
+        bool placed = false;          // holds a slot on its lane
+        std::uint32_t lane = 0;
+        bool deadlineIndexed = false; // has an entry in deadlines_
+        bool dispatched = false;      // handed to an executor, not reported back yet
+        bool deferred = false;        // left in the backlog by a full pass
+        std::uint64_t ticket = 0;     // identifies the current dispatch
+        std::chrono::system_clock::time_point placedAt;
+    };
+
+    // Place in the scheduling order: higher buckets come first
+    struct Position {
+        std::size_t bucket;
+        std::size_t index;
+    };
+
+    // Task storage. nameIndex_ maps names (viewing the store's copy) to
+    // handles and buckets_ lists the handles of each priority, so the
+    // scheduling order is kept without ever sorting. Removal leaves
+    // kInvalidHandle in the slot, so no other entry moves; a bucket is
+    // compacted once holes_ makes up half of it. The store sits behind a
+    // pointer because bound Task objects refer to it. Like the store's
+    // columns, these containers are paged copy-on-write (see CowVector), so
+    // a write after fork() copies the page it touches.
+    std::unique_ptr<TaskStore> store_;
+    CowVector<Entry> entries_;
+    CowHashMap<std::string_view, TaskHandle> nameIndex_;
+    std::array<CowVector<TaskHandle>, kPriorityCount> buckets_;
+    std::array<std::size_t, kPriorityCount> holes_{};
+
+    CowPtr<EventStore> calendar_events_;
+
+    // Busy time of calendar events and scheduled tasks. Tasks are keyed by
+    // their handle, events by their id with kEventKeyBit set.
+    static constexpr IntervalIndex::Key kEventKeyBit = IntervalIndex::Key(1) << 63;
+
+    // A lane's placed tasks are kept by start time. Placement gives each
+    // lane a cursor that only moves forward, so within a lane time order
+    // matches scheduling order.
+    struct Lane {
+        std::variant<IntervalIndex, BitmapTimeline> busy;
+        std::map<EventStore::Id, std::shared_ptr<const Recurrence>> recurring;
+        CowSet<std::pair<std::chrono::system_clock::time_point, TaskHandle>> placements;
+
+        explicit Lane(const std::chrono::minutes& granularity);
+        void occupy(IntervalIndex::Key key, const std::chrono::system_clock::time_point& start,
+                    const std::chrono::system_clock::time_point& end);
+        void occupy(std::vector<IntervalIndex::Item> items);
+        void vacate(IntervalIndex::Key key);
+        bool isFree(const std::chrono::system_clock::time_point& start,
+                    const std::chrono::system_clock::time_point& end) const;
+        std::chrono::system_clock::time_point findFirstFit(const std::chrono::system_clock::time_point& from,
+                                                           const std::chrono::minutes& duration) const;
+    };
+    CowPtr<std::vector<Lane>> lanes_;
+    std::chrono::minutes granularity_{0};
+
+    // Events that block a single lane; all others block every lane
+    CowPtr<std::unordered_map<EventStore::Id, std::size_t>> laneEvents_;
+
+    // Recurring tasks by series name. Occurrences due before expandedUntil
+    // exist as tasks already.
+    struct TaskSeries {
+        Recurrence due;
+        std::chrono::minutes duration;
+        Priority priority;
+        std::chrono::system_clock::time_point expandedUntil;
+    };
+    CowPtr<std::map<std::string, TaskSeries>> taskSeries_;
+
+    // Dependency edges per task handle, only sized once an edge exists
+    struct Links {
+        std::vector<TaskHandle> prerequisites;
+        std::vector<TaskHandle> dependents;
+    };
+    CowVector<Links> links_;
+    std::size_t dependencyCount_ = 0;
+    bool dependencyCycle_ = false;
+    CowPtr<std::vector<TaskTiming>> timings_;
+    CowPtr<std::vector<TaskHandle>> criticalPath_;
+    CowHashMap<TaskHandle, DurationEstimate> estimates_;
+
+    SchedulingPolicy policy_ = SchedulingPolicy::PRIORITY;
+
+    // Pending tasks ordered by deadline
+    CowSet<std::pair<std::chrono::system_clock::time_point, TaskHandle>> deadlines_;
+
+    // Fixed UTC offset for day views, local time zone when unset
+    std::optional<std::chrono::minutes> utcOffset_;
+
+    // Earliest position whose placement is no longer valid
+    std::optional<Position> dirty_;
+
+    // Horizon bounded passes. Incremental passes place a prefix of the
+    // scheduling order and the backlog starts at frontier_. A full pass can
+    // leave tasks out anywhere, so it flags them deferred instead and puts
+    // the frontier at the end of the order.
+    std::chrono::minutes horizon_{0};
+    std::chrono::system_clock::time_point horizonEnd_ = std::chrono::system_clock::time_point::max();
+    std::optional<Position> frontier_;
+
+    // Finished dispatches reported by executor threads
+    struct Completion {
+        TaskHandle handle;
+        std::uint64_t ticket;
+        bool succeeded;
+    };
+    std::mutex completionMutex_;
+    std::vector<Completion> completions_;
+    std::uint64_t nextTicket_ = 0;
+    std::function<void(const std::shared_ptr<Task>&)> completionCallback_;
+    
+    Journal* journal_ = nullptr;
+    
+    // Last, so its thread stops before anything it could report on goes
+    std::unique_ptr<TaskNotifier> notifier_;
     
     // Helper methods
-    bool isTimeSlotAvailable(const std::chrono::system_clock::time_point& start,
+    bool restore(const Snapshot& snapshot);
+    bool isTimeSlotAvailable(std::size_t lane, const std::chrono::system_clock::time_point& start,
                             const std::chrono::minutes& duration) const;
     std::chrono::system_clock::time_point findNextAvailableTimeSlot(
-        const std::chrono::system_clock::time_point& start,
+        std::size_t lane, const std::chrono::system_clock::time_point& start,
         const std::chrono::minutes& duration) const;
-    void sortTasksByPriority();
-}; 
\ No newline at end of file
+    std::chrono::system_clock::time_point startOfDay(const std::chrono::system_clock::time_point& time) const;
+    std::chrono::system_clock::time_point addDays(const std::chrono::system_clock::time_point& dayStart,
+                                                  int days) const;
+    void resetLanes(std::size_t lanes);
+    std::vector<std::pair<TaskHandle, std::chrono::minutes>> lateTasks() const;
+    void watchStore();
+    void noteCompletion(TaskHandle handle, bool completed);
+    void journalSettings();
+    void reserveTasks(const std::array<std::size_t, kPriorityCount>& counts);
+    TaskHandle registerTask(TaskHandle handle);
+    void placeTask(TaskHandle handle, std::size_t lane, const std::chrono::system_clock::time_point& start);
+    std::vector<TaskHandle> placedBetween(const std::chrono::system_clock::time_point& from,
+                                          const std::chrono::system_clock::time_point& to) const;
+    void blockLane(std::size_t lane, EventStore::Id id,
+                   const std::chrono::system_clock::time_point& start,
+                   const std::chrono::system_clock::time_point& end);
+    void blockLane(std::size_t lane, EventStore::Id id, const std::shared_ptr<const Recurrence>& recurrence);
+    void unblockLane(std::size_t lane, EventStore::Id id, const std::chrono::system_clock::time_point& start);
+    void expandRecurringTasks(const std::chrono::system_clock::time_point& now);
+    void releaseTimeSlot(TaskHandle handle);
+    void indexDeadline(TaskHandle handle);
+    void dropDeadline(TaskHandle handle);
+    void markDirty(TaskHandle handle);
+    void markDirty(const Position& position);
+    static bool precedes(const Position& a, const Position& b);
+    Position endPosition() const;
+    bool isBacklogged(TaskHandle handle) const;
+    std::chrono::system_clock::time_point passLimit(const std::chrono::system_clock::time_point& now);
+    void reflowFrom(const Position& position);
+    void deferFrom(const Position& position, const Position& released);
+    void scheduleFull();
+    void unlinkTask(TaskHandle handle);
+    std::int64_t laneTardiness(std::size_t lane) const;
+    void fileTask(TaskHandle handle, Priority priority);
+    void unfileTask(TaskHandle handle);
+    void compactBucket(std::size_t b);
+    std::size_t liveBefore(const Position& position) const;
+    void eraseTask(TaskHandle handle);
+};
+
+// Bulk load: one pass counts tasks per priority so every container grows
+// exactly once, the second pass files the tasks into their buckets.
+template <typename ForwardIt>
+void TaskScheduler::addTasks(ForwardIt first, ForwardIt last) {
+    std::array<std::size_t, kPriorityCount> counts{};
+    for (auto it = first; it != last; ++it) {
+        ++counts[static_cast<std::size_t>((*it)->getPriority())];
+    }
+    reserveTasks(counts);
+
+    for (; first != last; ++first) {
+        addTask(*first);
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Priority.hpp"
+#include "CowVector.hpp"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Task;
+class Snapshot;
+class SnapshotWriter;
+
+// Struct-of-arrays storage for the tasks of a TaskScheduler.
+//
+// Every field lives in its own column indexed by a stable integer handle,
+// so scheduling passes stream through durations, deadlines and completion
+// bits instead of chasing one heap object per task. Names
+// are stored once here and referenced by the scheduler's name index.
+//
+// Task objects are an optional compatibility layer on top: a Task bound to
+// a handle reads and writes its fields through the store, and tasks that
+// were added by handle only get a Task object the first time one is asked
+// for.
+//
+// Columns are paged copy-on-write vectors (see CowVector), so fork() is
+// O(1) and a write after it copies the pages it touches rather than whole
+// columns. Bound Task objects stay with the original; the fork creates its
+// own lazily.
+class TaskStore {
+public:
+    using Handle = std::uint32_t;
+    using TimePoint = std::chrono::system_clock::time_point;
+    static constexpr Handle kInvalidHandle = ~Handle(0);
+
+    TaskStore() = default;
+    ~TaskStore();
+    TaskStore(const TaskStore&) = delete;
+    TaskStore& operator=(const TaskStore&) = delete;
+
+    std::unique_ptr<TaskStore> fork() const;
+
+    // Snapshot columns, by handle. restore() fills an empty store and fails
+    // on inconsistent columns; payloads are not part of a snapshot.
+    void save(SnapshotWriter& writer) const;
+    bool restore(const Snapshot& snapshot);
+
+    // Task management
+    Handle create(const std::string& name, const std::chrono::minutes& duration,
+                  Priority priority, const TimePoint& deadline);
+    void destroy(Handle handle);
+    void reserve(std::size_t count);
+    bool isValid(Handle handle) const { return handle < live_.size() && live_[handle]; }
+    std::size_t capacity() const { return live_.size(); }
+
+    // Columns
+    const std::string& name(Handle handle) const { return *names_[handle]; }
+    std::chrono::minutes duration(Handle handle) const { return durations_[handle]; }
+    Priority priority(Handle handle) const { return priorities_[handle]; }
+    TimePoint deadline(Handle handle) const { return deadlines_[handle]; }
+    TimePoint scheduledTime(Handle handle) const { return scheduledTimes_[handle]; }
+    bool isCompleted(Handle handle) const { return (completed_[handle >> 6] >> (handle & 63)) & 1; }
+
+    void setScheduledTime(Handle handle, const TimePoint& time) { scheduledTimes_[handle] = time; }
+    void setPriority(Handle handle, Priority priority) { priorities_[handle] = priority; }
+    void setCompleted(Handle handle, bool completed);
+
+    // Priority and completion changes made through bound Task objects go
+    // to the handlers, so the owner can refile or replan the task; without
+    // one they only write the column. Forks start without handlers.
+    void setPriorityHandler(std::function<void(Handle, Priority)> handler) { priorityHandler_ = std::move(handler); }
+    void setCompletionHandler(std::function<void(Handle, bool)> handler) { completionHandler_ = std::move(handler); }
+    void changePriority(Handle handle, Priority priority);
+    void changeCompleted(Handle handle, bool completed);
+
+    // Work run when the task is executed, empty if there is none
+    const std::function<void()>& payload(Handle handle) const { return payloads_[handle]; }
+    void setPayload(Handle handle, std::function<void()> payload) { payloads_[handle] = std::move(payload); }
+
+    // Compatibility with the shared_ptr<Task> API. object() creates the
+    // Task on first use, so unlike the column reads it is a write and must
+    // not run concurrently with anything else on the store.
+    void bind(Handle handle, const std::shared_ptr<Task>& task);
+    const std::shared_ptr<Task>& object(Handle handle);
+
+private:
+    // Names live on the heap so views of them stay valid in every fork
+    using Name = std::shared_ptr<const std::string>;
+
+    CowVector<Name> names_;
+    CowVector<std::chrono::minutes> durations_;
+    CowVector<Priority> priorities_;
+    CowVector<TimePoint> deadlines_;
+    CowVector<TimePoint> scheduledTimes_;
+    CowVector<std::uint64_t> completed_;   // one bit per handle
+    CowVector<std::function<void()>> payloads_;
+    CowVector<std::uint8_t> live_;
+    CowVector<Handle> freeHandles_;
+
+    // Task objects bound to handles, created lazily; never shared with forks
+    std::vector<std::shared_ptr<Task>> objects_;
+    std::function<void(Handle, Priority)> priorityHandler_;
+    std::function<void(Handle, bool)> completionHandler_;
+
+    std::shared_ptr<Task>& objectSlot(Handle handle);
+};
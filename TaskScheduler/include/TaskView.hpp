@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Task.hpp"
+#include "CowVector.hpp"
+#include "TaskStore.hpp"
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+// Non-owning view over a priority bucket of a TaskScheduler.
+//
+// Creating a view costs O(1) and copies nothing; iterating it yields the
+// store's own shared_ptr<Task> references. Buckets keep the slots of
+// removed tasks as kInvalidHandle until they are compacted, and iterating
+// steps over those. A view is only valid until the scheduler it came from
+// is modified, and since iterating may create Task objects it must not be
+// used from several threads at once.
+class TaskView {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::shared_ptr<Task>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::shared_ptr<Task>*;
+        using reference = const std::shared_ptr<Task>&;
+        using Handles = CowVector<TaskStore::Handle>::const_iterator;
+
+        iterator() = default;
+        iterator(TaskStore* store, Handles handle, Handles end) : store_(store), handle_(handle), end_(end) {
+            skipForward();
+        }
+
+        reference operator*() const { return store_->object(*handle_); }
+        pointer operator->() const { return &store_->object(*handle_); }
+
+        // Never stepped back past begin(), which is a live slot
+        iterator& operator++() { ++handle_; skipForward(); return *this; }
+        iterator operator++(int) { iterator copy = *this; ++*this; return copy; }
+        iterator& operator--() {
+            do {
+                --handle_;
+            } while (*handle_ == TaskStore::kInvalidHandle);
+            return *this;
+        }
+        iterator operator--(int) { iterator copy = *this; --*this; return copy; }
+
+        bool operator==(const iterator& other) const { return handle_ == other.handle_; }
+        bool operator!=(const iterator& other) const { return handle_ != other.handle_; }
+
+    private:
+        TaskStore* store_ = nullptr;
+        Handles handle_;
+        Handles end_;
+
+        void skipForward() {
+            while (handle_ != end_ && *handle_ == TaskStore::kInvalidHandle) {
+                ++handle_;
+            }
+        }
+    };
+
+    // `size` counts the live slots of `handles`
+    TaskView(TaskStore& store, const CowVector<TaskStore::Handle>& handles, std::size_t size)
+        : store_(&store), handles_(&handles), size_(size) {}
+
+    iterator begin() const { return iterator(store_, handles_->begin(), handles_->end()); }
+    iterator end() const { return iterator(store_, handles_->end(), handles_->end()); }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    TaskStore* store_;
+    const CowVector<TaskStore::Handle>* handles_;
+    std::size_t size_;
+};
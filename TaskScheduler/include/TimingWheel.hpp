@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Bits.hpp"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Hierarchical timing wheel over integer ticks.
+//
+// Six levels of 64 slots each: level l covers 64^(l+1) ticks in slots of
+// 64^l ticks. A timer goes to the level of the highest 6-bit digit in which
+// its tick differs from the current one, so arming and cancelling are O(1)
+// list operations. Whenever a digit of the current tick rolls over, the
+// matching slot one level up is cascaded into the levels below it. Timers
+// beyond the top level wait in an overflow list until they come in range.
+//
+// Timers are 32 byte nodes in one pool, linked by index, with a free list;
+// an occupancy bitmap per level lets advance() skip empty stretches and
+// nextExpiry() find the next tick with work without scanning slots.
+// Not thread-safe.
+class TimingWheel {
+public:
+    using Tick = std::int64_t;
+    using TimerId = std::uint64_t;    // generation << 32 | pool index, never 0
+
+    explicit TimingWheel(Tick now);
+
+    // Timers for a tick at or before now() fire on the next advance()
+    TimerId arm(Tick when, std::uint64_t payload);
+    bool cancel(TimerId id);
+    std::size_t size() const { return armed_; }
+    Tick now() const { return now_; }
+
+    // Moves to `target` and calls fire(payload, tick) for every timer due
+    // by then, earlier ticks first. Timers that were overdue when armed all
+    // come first, in no particular order.
+    template <typename Fire>
+    void advance(Tick target, Fire&& fire);
+
+    // Earliest tick at which advance() has something to do: fire a timer
+    // or cascade a slot. Empty without timers.
+    std::optional<Tick> nextExpiry() const;
+
+private:
+    static constexpr int kBits = 6;
+    static constexpr int kSlots = 1 << kBits;
+    static constexpr int kLevels = 6;
+    static constexpr std::uint32_t kNone = ~std::uint32_t(0);
+    static constexpr std::uint8_t kOverflow = kLevels;
+
+    struct Node {
+        Tick when;
+        std::uint64_t payload;
+        std::uint32_t next;
+        std::uint32_t prev;
+        std::uint32_t generation;
+        std::uint8_t level;      // kOverflow for the overflow list
+        std::uint8_t slot;
+        bool armed;
+    };
+
+    Tick now_;
+    std::vector<Node> nodes_;
+    std::uint32_t freeList_ = kNone;
+    std::size_t armed_ = 0;
+    std::array<std::array<std::uint32_t, kSlots>, kLevels> slots_;
+    std::array<std::uint64_t, kLevels> occupied_{};
+    std::uint32_t overflow_ = kNone;
+
+    std::uint32_t& head(std::uint8_t level, std::uint8_t slot);
+    void link(std::uint32_t index);
+    void unlink(std::uint32_t index);
+    std::uint32_t takeSlot(int level, int slot);
+    void release(std::uint32_t index);
+};
+
+template <typename Fire>
+void TimingWheel::advance(Tick target, Fire&& fire) {
+    // Overdue timers wait in the current tick's slot
+    auto fireCurrent = [&] {
+        for (auto index = takeSlot(0, static_cast<int>(now_ & (kSlots - 1))); index != kNone;) {
+            auto next = nodes_[index].next;
+            auto payload = nodes_[index].payload;
+            auto when = nodes_[index].when;
+            release(index);
+            fire(payload, when);
+            index = next;
+        }
+    };
+    fireCurrent();
+    while (now_ < target) {
+        // Jump to the next occupied level 0 slot or the next rollover
+        Tick step = kSlots - (now_ & (kSlots - 1));
+        auto position = static_cast<int>(now_ & (kSlots - 1));
+        std::uint64_t ahead = position + 1 < kSlots ? occupied_[0] >> (position + 1) << (position + 1) : 0;
+        if (ahead != 0) {
+            step = countTrailingZeros(ahead) - position;
+        }
+        if (now_ + step > target) {
+            now_ = target;
+            return;
+        }
+        now_ += step;
+
+        // Cascade every level whose digit rolled over, the highest first
+        if ((now_ & (kSlots - 1)) == 0) {
+            int top = 1;
+            while (top < kLevels && ((now_ >> (kBits * top)) & (kSlots - 1)) == 0) {
+                ++top;
+            }
+            if (top == kLevels) {
+                auto index = overflow_;
+                overflow_ = kNone;
+                while (index != kNone) {
+                    auto next = nodes_[index].next;
+                    link(index);
+                    index = next;
+                }
+                top = kLevels - 1;
+            }
+            for (int level = top; level >= 1; --level) {
+                auto slot = static_cast<int>((now_ >> (kBits * level)) & (kSlots - 1));
+                for (auto index = takeSlot(level, slot); index != kNone;) {
+                    auto next = nodes_[index].next;
+                    link(index);
+                    index = next;
+                }
+            }
+        }
+        fireCurrent();
+    }
+}
@@ -0,0 +1,285 @@
+#include "../include/BitmapTimeline.hpp"
+#include "../include/Bits.hpp"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+constexpr std::uint64_t kAllBusy = ~std::uint64_t(0);
+
+std::int64_t floorDiv(std::int64_t value, std::int64_t divisor) {
+    std::int64_t quotient = value / divisor;
+    return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+}
+
+std::int64_t ceilDiv(std::int64_t value, std::int64_t divisor) {
+    return floorDiv(value, divisor) + (value % divisor != 0 ? 1 : 0);
+}
+
+// Both take a non-zero word
+int lowestBit(std::uint64_t word) { return countTrailingZeros(word); }
+int highestFreeBits(std::uint64_t busy) { return countLeadingZeros(busy); }
+
+// Bits [from, to) of a word, 0 <= from <= to <= 64
+std::uint64_t bitRange(int from, int to) {
+    std::uint64_t upper = to == 64 ? kAllBusy : (std::uint64_t(1) << to) - 1;
+    return upper & (kAllBusy << from);
+}
+
+// Bit i is set when bits i .. i + length - 1 of `free` are all set. Each
+// step doubles the run length already checked, so this is log2(length) ANDs.
+std::uint64_t runStarts(std::uint64_t free, std::int64_t length) {
+    std::int64_t checked = 1;
+    while (checked < length && free) {
+        std::int64_t shift = std::min(checked, length - checked);
+        free &= free >> shift;
+        checked += shift;
+    }
+    return free;
+}
+
+}
+
+BitmapTimeline::BitmapTimeline(const Duration& granularity)
+    : granularity_(std::max(granularity, Duration(1))) {}
+
+void BitmapTimeline::insert(Key key, const TimePoint& start, const TimePoint& end) {
+    erase(key);
+    Interval interval{quantumFloor(start), start < end ? quantumCeil(end) : quantumFloor(start)};
+    intervals_.emplace(key, interval);
+    byFirst_.insert({interval.first, key});
+    if (interval.first < interval.last) {
+        lengths_.insert(interval.last - interval.first);
+        cover(interval.first, interval.last);
+        mark(interval.first, interval.last);
+    }
+}
+
+bool BitmapTimeline::erase(Key key) {
+    const Interval* found = intervals_.find(key);
+    if (!found) {
+        return false;
+    }
+
+    Interval interval = *found;
+    intervals_.erase(key);
+    byFirst_.erase({interval.first, key});
+
+    if (interval.first < interval.last) {
+        lengths_.erase(interval.last - interval.first);
+
+        // Bits don't count owners, so set them again for whatever else overlaps
+        unmark(interval.first, interval.last);
+        auto longest = lengths_.empty() ? 0 : *std::prev(lengths_.end());
+        auto last = byFirst_.lower_bound({interval.last, 0});
+        for (auto pos = byFirst_.lower_bound({interval.first - longest, 0}); pos != last; ++pos) {
+            const Interval& other = *intervals_.find(pos->second);
+            if (other.last > interval.first) {
+                mark(std::max(other.first, interval.first), std::min(other.last, interval.last));
+            }
+        }
+    }
+    if (intervals_.empty()) {
+        clear();
+    }
+    return true;
+}
+
+void BitmapTimeline::clear() {
+    intervals_.clear();
+    byFirst_.clear();
+    lengths_.clear();
+    baseWord_ = 0;
+    words_.clear();
+    full_.clear();
+}
+
+bool BitmapTimeline::isFree(const TimePoint& start, const TimePoint& end) const {
+    if (!(start < end)) {
+        return true;
+    }
+
+    std::int64_t first = std::max(quantumFloor(start), baseWord_ * 64);
+    std::int64_t last = std::min(quantumCeil(end), (baseWord_ + std::int64_t(words_.size())) * 64);
+    while (first < last) {
+        std::int64_t word = floorDiv(first, 64);
+        int from = static_cast<int>(first - word * 64);
+        int to = static_cast<int>(std::min<std::int64_t>(last - word * 64, 64));
+        if (words_[word - baseWord_] & bitRange(from, to)) {
+            return false;
+        }
+        first = word * 64 + to;
+    }
+    return true;
+}
+
+BitmapTimeline::TimePoint BitmapTimeline::findFirstFit(
+    const TimePoint& from, const Duration& duration) const {
+
+    if (duration <= Duration::zero()) {
+        return from;
+    }
+
+    std::int64_t length = ceilDiv(duration.count(), granularity_.count());
+    std::int64_t start = quantumCeil(from);
+    std::int64_t begin = baseWord_ * 64;
+    std::int64_t end = begin + std::int64_t(words_.size()) * 64;
+    if (start >= end || start + length <= begin) {
+        return timeOf(start);
+    }
+
+    // Current run of free quanta, carried from word to word
+    std::int64_t runStart = start;
+    std::int64_t runLength = 0;
+    std::size_t word = 0;
+    std::uint64_t skipped = 0;
+    if (start < begin) {
+        runLength = begin - start;
+    } else {
+        word = static_cast<std::size_t>(floorDiv(start, 64) - baseWord_);
+        skipped = bitRange(0, static_cast<int>(start - (baseWord_ + std::int64_t(word)) * 64));
+    }
+
+    while (word < words_.size()) {
+        std::uint64_t busy = words_[word] | skipped;
+        std::int64_t wordStart = (baseWord_ + std::int64_t(word)) * 64;
+        skipped = 0;
+
+        if (busy == 0) {
+            if (runLength == 0) {
+                runStart = wordStart;
+            }
+            runLength += 64;
+            if (runLength >= length) {
+                return timeOf(runStart);
+            }
+            ++word;
+            continue;
+        }
+        if (busy == kAllBusy) {
+            runLength = 0;
+            word = nextNonFull(word + 1);
+            continue;
+        }
+
+        // A run from earlier words may end in this word's low bits
+        if (runLength > 0 && runLength + lowestBit(busy) >= length) {
+            return timeOf(runStart);
+        }
+        if (length <= 64) {
+            std::uint64_t starts = runStarts(~busy, length);
+            if (starts) {
+                return timeOf(wordStart + lowestBit(starts));
+            }
+        }
+        // Free high bits may start a run that continues in the next word
+        runLength = highestFreeBits(busy);
+        runStart = wordStart + 64 - runLength;
+        ++word;
+    }
+
+    // Everything past the bitmap is free
+    return timeOf(runLength > 0 ? runStart : end);
+}
+
+// End of the stored span, which covers every busy quantum
+BitmapTimeline::TimePoint BitmapTimeline::end() const {
+    if (intervals_.empty()) {
+        return TimePoint::min();
+    }
+    return timeOf((baseWord_ + std::int64_t(words_.size())) * 64);
+}
+
+std::int64_t BitmapTimeline::quantumFloor(const TimePoint& time) const {
+    return floorDiv(time.time_since_epoch().count(), granularity_.count());
+}
+
+std::int64_t BitmapTimeline::quantumCeil(const TimePoint& time) const {
+    return ceilDiv(time.time_since_epoch().count(), granularity_.count());
+}
+
+BitmapTimeline::TimePoint BitmapTimeline::timeOf(std::int64_t quantum) const {
+    return TimePoint(granularity_ * quantum);
+}
+
+// Grows the bitmap so quanta [first, last) have bits
+void BitmapTimeline::cover(std::int64_t first, std::int64_t last) {
+    std::int64_t firstWord = floorDiv(first, 64);
+    std::int64_t lastWord = floorDiv(last - 1, 64);
+    if (words_.empty()) {
+        baseWord_ = firstWord;
+        words_.assign(static_cast<std::size_t>(lastWord - firstWord + 1), 0);
+        full_.assign((words_.size() + 63) / 64, 0);
+        return;
+    }
+
+    if (firstWord < baseWord_) {
+        // Word indices shift, so the words are copied over and the summary
+        // is rebuilt
+        CowVector<std::uint64_t> words;
+        words.assign(static_cast<std::size_t>(baseWord_ - firstWord), 0);
+        for (auto word : words_) {
+            words.push_back(word);
+        }
+        words_ = words;
+        baseWord_ = firstWord;
+        full_.assign((words_.size() + 63) / 64, 0);
+        for (std::size_t word = 0; word < words_.size(); ++word) {
+            updateFull(word);
+        }
+    }
+    if (lastWord >= baseWord_ + std::int64_t(words_.size())) {
+        words_.resize(static_cast<std::size_t>(lastWord - baseWord_ + 1), 0);
+        full_.resize((words_.size() + 63) / 64, 0);
+    }
+}
+
+void BitmapTimeline::mark(std::int64_t first, std::int64_t last) {
+    while (first < last) {
+        std::int64_t word = floorDiv(first, 64);
+        int from = static_cast<int>(first - word * 64);
+        int to = static_cast<int>(std::min<std::int64_t>(last - word * 64, 64));
+        auto index = static_cast<std::size_t>(word - baseWord_);
+        words_[index] |= bitRange(from, to);
+        updateFull(index);
+        first = word * 64 + to;
+    }
+}
+
+void BitmapTimeline::unmark(std::int64_t first, std::int64_t last) {
+    while (first < last) {
+        std::int64_t word = floorDiv(first, 64);
+        int from = static_cast<int>(first - word * 64);
+        int to = static_cast<int>(std::min<std::int64_t>(last - word * 64, 64));
+        auto index = static_cast<std::size_t>(word - baseWord_);
+        words_[index] &= ~bitRange(from, to);
+        updateFull(index);
+        first = word * 64 + to;
+    }
+}
+
+void BitmapTimeline::updateFull(std::size_t word) {
+    std::uint64_t bit = std::uint64_t(1) << (word & 63);
+    if (std::as_const(words_)[word] == kAllBusy) {
+        full_[word >> 6] |= bit;
+    } else {
+        full_[word >> 6] &= ~bit;
+    }
+}
+
+// First word at or after `word` with a free bit, or words_.size()
+std::size_t BitmapTimeline::nextNonFull(std::size_t word) const {
+    std::size_t group = word >> 6;
+    if (group >= full_.size()) {
+        return words_.size();
+    }
+    std::uint64_t open = ~full_[group] & (kAllBusy << (word & 63));
+    while (open == 0) {
+        if (++group == full_.size()) {
+            return words_.size();
+        }
+        open = ~full_[group];
+    }
+    return std::min(words_.size(), (group << 6) + lowestBit(open));
+}
@@ -0,0 +1,128 @@
+#include "../include/ConcurrentScheduler.hpp"
+
+namespace {
+
+// Producers keep their Task objects, the scheduler gets a copy of the values
+std::shared_ptr<Task> copyTask(const Task& task) {
+    auto copy = std::make_shared<Task>(task.getName(), task.getDuration(),
+                                       task.getPriority(), task.getDeadline());
+    copy->setCompleted(task.isCompleted());
+    copy->setPayload(task.getPayload());
+    return copy;
+}
+
+}
+
+SchedulerSnapshot::SchedulerSnapshot() : scheduler_(std::make_unique<const TaskScheduler>()) {}
+
+std::optional<SchedulerSnapshot::TaskInfo> SchedulerSnapshot::find(const std::string& name) const {
+    auto handle = scheduler_->findTask(name);
+    if (handle == TaskStore::kInvalidHandle) {
+        return std::nullopt;
+    }
+    const auto& store = scheduler_->getTaskStore();
+    return TaskInfo{store.name(handle), store.duration(handle), store.priority(handle),
+                    store.deadline(handle), store.scheduledTime(handle), store.isCompleted(handle)};
+}
+
+ConcurrentScheduler::ConcurrentScheduler()
+    : snapshot_(std::make_shared<const SchedulerSnapshot>())
+    , owner_(&ConcurrentScheduler::run, this) {
+}
+
+ConcurrentScheduler::~ConcurrentScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_one();
+    owner_.join();
+}
+
+void ConcurrentScheduler::addTask(const std::shared_ptr<Task>& task) {
+    submit([task = copyTask(*task)](TaskScheduler& scheduler) { scheduler.addTask(task); });
+}
+
+void ConcurrentScheduler::updateTask(const std::string& taskName, const std::shared_ptr<Task>& newTask) {
+    submit([taskName, task = copyTask(*newTask)](TaskScheduler& scheduler) {
+        scheduler.updateTask(taskName, task);
+    });
+}
+
+void ConcurrentScheduler::removeTask(const std::string& taskName) {
+    submit([taskName](TaskScheduler& scheduler) { scheduler.removeTask(taskName); });
+}
+
+void ConcurrentScheduler::completeTask(const std::string& taskName) {
+    submit([taskName](TaskScheduler& scheduler) { scheduler.completeTask(taskName); });
+}
+
+void ConcurrentScheduler::submit(Mutation mutation) {
+    queue_.push(std::move(mutation));
+    queued_.fetch_add(1);
+
+    // Only take the lock when the owner actually sleeps
+    if (ownerSleeping_.load()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        workAvailable_.notify_one();
+    }
+}
+
+std::shared_ptr<const SchedulerSnapshot> ConcurrentScheduler::snapshot() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void ConcurrentScheduler::flush() {
+    auto target = queued_.load();
+    std::unique_lock<std::mutex> lock(mutex_);
+    batchPublished_.wait(lock, [this, target] { return published_.load() >= target; });
+}
+
+void ConcurrentScheduler::run() {
+    std::uint64_t applied = 0;
+    std::uint64_t version = 0;
+    Mutation mutation;
+
+    while (true) {
+        std::size_t batch = 0;
+        while (batch < kMaxBatch && queue_.pop(mutation)) {
+            mutation(scheduler_);
+            mutation = nullptr;
+            ++batch;
+        }
+
+        if (batch > 0) {
+            applied += batch;
+            scheduler_.rescheduleTasks();
+            publish(++version);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                published_ = applied;
+            }
+            batchPublished_.notify_all();
+            continue;
+        }
+
+        // A push may be counted but not linked yet; wait for it without sleeping
+        if (queued_.load() > applied) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        ownerSleeping_ = true;
+        workAvailable_.wait(lock, [this, applied] { return queued_.load() > applied || stopping_.load(); });
+        ownerSleeping_ = false;
+        if (stopping_ && queued_.load() == applied) {
+            return;
+        }
+    }
+}
+
+void ConcurrentScheduler::publish(std::uint64_t version) {
+    auto snapshot = std::make_shared<SchedulerSnapshot>();
+    snapshot->version = version;
+    snapshot->scheduler_ = scheduler_.fork();
+
+    std::atomic_store(&snapshot_, std::shared_ptr<const SchedulerSnapshot>(std::move(snapshot)));
+}
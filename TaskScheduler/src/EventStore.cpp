@@ -0,0 +1,99 @@
+#include "../include/EventStore.hpp"
+
+EventStore::Id EventStore::add(const TimePoint& start, const TimePoint& end,
+                               const std::string& description) {
+    Id id = nextId_;
+    insert(id, start, end, description);
+    return id;
+}
+
+EventStore::Id EventStore::add(const TimePoint& start, const TimePoint& end, const std::string& description,
+                               const RecurrenceRule& rule) {
+    Id id = nextId_;
+    insert(id, start, end, description, rule);
+    return id;
+}
+
+bool EventStore::insert(Id id, const TimePoint& start, const TimePoint& end, const std::string& description) {
+    if (!events_.emplace(id, CalendarEvent{start, end, description}).second) {
+        return false;
+    }
+    byDescription_[description].insert(id);
+    byTime_.insert(id, start, end);
+    skipIds(id + 1);
+    return true;
+}
+
+bool EventStore::insert(Id id, const TimePoint& start, const TimePoint& end, const std::string& description,
+                        const RecurrenceRule& rule) {
+    if (!events_.emplace(id, CalendarEvent{start, end, description}).second) {
+        return false;
+    }
+    byDescription_[description].insert(id);
+    recurring_.emplace(id, std::make_shared<const Recurrence>(start, end - start, rule));
+    skipIds(id + 1);
+    return true;
+}
+
+bool EventStore::remove(Id id) {
+    auto it = events_.find(id);
+    if (it == events_.end()) {
+        return false;
+    }
+
+    auto bucket = byDescription_.find(it->second.description);
+    bucket->second.erase(id);
+    if (bucket->second.empty()) {
+        byDescription_.erase(bucket);
+    }
+    if (!recurring_.erase(id)) {
+        byTime_.erase(id);
+    }
+    events_.erase(it);
+    return true;
+}
+
+void EventStore::clear() {
+    events_.clear();
+    byDescription_.clear();
+    byTime_.clear();
+    recurring_.clear();
+}
+
+const CalendarEvent* EventStore::find(Id id) const {
+    auto it = events_.find(id);
+    return it != events_.end() ? &it->second : nullptr;
+}
+
+std::vector<EventStore::Id> EventStore::findByDescription(const std::string& description) const {
+    auto bucket = byDescription_.find(description);
+    if (bucket == byDescription_.end()) {
+        return {};
+    }
+    return std::vector<Id>(bucket->second.begin(), bucket->second.end());
+}
+
+std::vector<EventStore::Id> EventStore::overlapping(const TimePoint& from, const TimePoint& to) const {
+    std::vector<Id> result;
+    byTime_.overlapping(from, to, result);
+    return result;
+}
+
+std::shared_ptr<const Recurrence> EventStore::findRecurrence(Id id) const {
+    auto it = recurring_.find(id);
+    return it != recurring_.end() ? it->second : nullptr;
+}
+
+// Occurrences of recurring events overlapping [from, to)
+void EventStore::occurrences(const TimePoint& from, const TimePoint& to,
+                             std::vector<CalendarEvent>& result) const {
+    std::vector<TimePoint> starts;
+    for (const auto& [id, recurrence] : recurring_) {
+        starts.clear();
+        recurrence->overlapping(from, to, starts);
+        const auto& description = events_.at(id).description;
+        for (const auto& start : starts) {
+            result.push_back(CalendarEvent{start, start + recurrence->length(), description});
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#include "../include/Executor.hpp"
+#include <algorithm>
+
+namespace {
+
+// Worker the current thread runs as, so nested submissions stay local
+thread_local const Executor* currentExecutor = nullptr;
+thread_local std::size_t currentWorker = 0;
+
+constexpr int kSpinRounds = 64;
+
+} // namespace
+
+Executor::Executor(std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    threads_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back(&Executor::workerLoop, this, i);
+    }
+}
+
+Executor::~Executor() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void Executor::submit(Job job, Priority priority) {
+    std::size_t index = currentExecutor == this
+        ? currentWorker
+        : nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+    auto level = static_cast<std::size_t>(priority);
+    unfinished_.fetch_add(1);
+    {
+        auto& worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs[level].push_back(std::move(job));
+        queuedAt_[level].fetch_add(1);
+    }
+    queued_.fetch_add(1);
+
+    // Only pay for the wake-up when someone is actually asleep
+    if (sleepers_.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        workAvailable_.notify_one();
+    }
+}
+
+void Executor::wait() {
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    allDone_.wait(lock, [this] { return unfinished_.load() == 0; });
+}
+
+void Executor::Batch::submit(Job job, Priority priority) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_;
+    }
+    executor_.submit([this, job = std::move(job)] {
+        // Counts the job as done even if it throws
+        struct Finish {
+            Batch* batch;
+            ~Finish() { batch->finish(); }
+        } finish{this};
+        job();
+    }, priority);
+}
+
+void Executor::Batch::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+// Notifies under the lock, so a waiter cannot return and destroy the
+// batch before this is done with it
+void Executor::Batch::finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0) {
+        done_.notify_all();
+    }
+}
+
+void Executor::workerLoop(std::size_t index) {
+    currentExecutor = this;
+    currentWorker = index;
+
+    Job job;
+    while (true) {
+        bool found = false;
+        for (int round = 0; round < kSpinRounds && !found; ++round) {
+            found = takeJob(index, job);
+            if (!found) {
+                std::this_thread::yield();
+            }
+        }
+
+        if (found) {
+            try {
+                job();
+            } catch (...) {
+            }
+            job = nullptr;
+            finishJob();
+            continue;
+        }
+
+        // Nothing to do anywhere, go to sleep
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleepers_.fetch_add(1);
+        workAvailable_.wait(lock, [this] { return queued_.load() > 0 || stopping_.load(); });
+        sleepers_.fetch_sub(1);
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
+
+bool Executor::takeJob(std::size_t index, Job& job) {
+    if (queued_.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    // Highest level first. The counts are only a hint: a level that looks
+    // empty may just be filling, the next round picks it up.
+    for (auto level = kPriorityLevels; level-- > 0;) {
+        if (queuedAt_[level].load(std::memory_order_relaxed) > 0 && takeJob(index, level, job)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Executor::takeJob(std::size_t index, std::size_t level, Job& job) {
+    // Own deque first, from the front
+    {
+        auto& jobs = workers_[index]->jobs[level];
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        if (!jobs.empty()) {
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            queuedAt_[level].fetch_sub(1);
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Then steal from the back of the others
+    for (std::size_t offset = 1; offset < workers_.size(); ++offset) {
+        auto& victim = *workers_[(index + offset) % workers_.size()];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (lock.owns_lock() && !victim.jobs[level].empty()) {
+            job = std::move(victim.jobs[level].back());
+            victim.jobs[level].pop_back();
+            queuedAt_[level].fetch_sub(1);
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Executor::finishJob() {
+    if (unfinished_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        allDone_.notify_all();
+    }
+}
@@ -0,0 +1,358 @@
+#include "../include/IntervalIndex.hpp"
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+IntervalIndex::IntervalIndex() : seed_(0x9e3779b9u) {}
+
+void IntervalIndex::insert(Key key, const TimePoint& start, const TimePoint& end) {
+    erase(key);
+    intervals_.emplace(key, Interval{start, end});
+    byStart_.insert({start, key});
+    if (start < end) {
+        addBlock(start, end);
+    }
+}
+
+void IntervalIndex::insert(std::vector<Item> items) {
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.start < b.start; });
+    intervals_.reserve(intervals_.size() + items.size());
+    for (const auto& item : items) {
+        erase(item.key);
+        intervals_.emplace(item.key, Interval{item.start, item.end});
+        byStart_.insert({item.start, item.key});
+    }
+
+    // Current blocks in order, merged with the new intervals
+    std::vector<Interval> blocks;
+    blocks.reserve(nodes_.size() - freeNodes_.size() + items.size());
+    std::vector<int> stack;
+    const auto& nodes = nodes_;
+    for (int node = root_; node != -1 || !stack.empty();) {
+        if (node != -1) {
+            stack.push_back(node);
+            node = nodes[node].left;
+        } else {
+            node = stack.back();
+            stack.pop_back();
+            blocks.push_back(Interval{nodes[node].start, nodes[node].end});
+            node = nodes[node].right;
+        }
+    }
+    std::size_t existing = blocks.size();
+    for (const auto& item : items) {
+        if (item.start < item.end) {
+            blocks.push_back(Interval{item.start, item.end});
+        }
+    }
+    std::inplace_merge(blocks.begin(), blocks.begin() + existing, blocks.end(),
+                       [](const Interval& a, const Interval& b) { return a.start < b.start; });
+    std::size_t count = 0;
+    for (const auto& block : blocks) {
+        if (count > 0 && block.start < blocks[count - 1].end) {
+            blocks[count - 1].end = std::max(blocks[count - 1].end, block.end);
+        } else {
+            blocks[count++] = block;
+        }
+    }
+    blocks.resize(count);
+
+    // Balanced rebuild. Sorted random priorities handed out level by level
+    // keep the heap order, so later inserts see an ordinary treap.
+    nodes_.clear();
+    freeNodes_.clear();
+    nodes_.reserve(count);
+    std::vector<std::size_t> depths;
+    depths.reserve(count);
+    root_ = build(blocks, 0, count, 0, depths);
+    std::vector<std::uint32_t> priorities(count);
+    for (auto& priority : priorities) {
+        priority = nextPriority();
+    }
+    std::sort(priorities.begin(), priorities.end(), std::greater<std::uint32_t>());
+    std::vector<int> byDepth(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        byDepth[i] = static_cast<int>(i);
+    }
+    std::stable_sort(byDepth.begin(), byDepth.end(), [&](int a, int b) { return depths[a] < depths[b]; });
+    for (std::size_t i = 0; i < count; ++i) {
+        nodes_[byDepth[i]].priority = priorities[i];
+    }
+}
+
+bool IntervalIndex::erase(Key key) {
+    const Interval* found = intervals_.find(key);
+    if (!found) {
+        return false;
+    }
+
+    Interval interval = *found;
+    intervals_.erase(key);
+    byStart_.erase({interval.start, key});
+
+    if (interval.start < interval.end) {
+        // Drop the block that covered this interval and rebuild it from
+        // whatever other intervals it was merged from.
+        int block = findBlockAtOrBefore(interval.start);
+        TimePoint blockStart = std::as_const(nodes_)[block].start;
+        TimePoint blockEnd = std::as_const(nodes_)[block].end;
+        removeBlock(blockStart);
+
+        auto first = byStart_.lower_bound({blockStart, 0});
+        auto last = byStart_.lower_bound({blockEnd, 0});
+        for (auto pos = first; pos != last; ++pos) {
+            const Interval& part = *intervals_.find(pos->second);
+            if (part.start < part.end) {
+                addBlock(part.start, part.end);
+            }
+        }
+    }
+    return true;
+}
+
+void IntervalIndex::clear() {
+    intervals_.clear();
+    byStart_.clear();
+    nodes_.clear();
+    freeNodes_.clear();
+    root_ = -1;
+}
+
+bool IntervalIndex::isFree(const TimePoint& start, const TimePoint& end) const {
+    if (!(start < end)) {
+        return true;
+    }
+    // Blocks are disjoint, so only the last block starting before `end` can overlap
+    int block = findBlockAtOrBefore(end - Duration(1));
+    return block == -1 || nodes_[block].end <= start;
+}
+
+IntervalIndex::TimePoint IntervalIndex::findFirstFit(
+    const TimePoint& from, const Duration& duration) const {
+
+    if (duration <= Duration::zero()) {
+        return from;
+    }
+
+    // First block that is not entirely before `from`
+    int block = findBlockAtOrBefore(from);
+    if (block == -1 || nodes_[block].end <= from) {
+        block = findBlockAfter(from);
+    }
+    if (block == -1 || nodes_[block].start >= from + duration) {
+        return from;
+    }
+
+    // Otherwise the answer is the end of the first block from here on that
+    // is followed by a large enough gap, or the end of the last block.
+    Prev prev;
+    TimePoint result;
+    if (findGap(root_, nodes_[block].start, duration, prev, result)) {
+        return result;
+    }
+    return nodes_[root_].lastEnd;
+}
+
+IntervalIndex::TimePoint IntervalIndex::end() const {
+    return root_ == -1 ? TimePoint::min() : nodes_[root_].lastEnd;
+}
+
+void IntervalIndex::addBlock(TimePoint start, TimePoint end) {
+    // Merge with every block that overlaps [start, end). Blocks that only
+    // touch are kept apart so erasing one interval stays cheap.
+    std::vector<TimePoint> merged;
+    const auto& nodes = nodes_;
+    int block = findBlockAtOrBefore(start);
+    if (block == -1 || nodes[block].end <= start) {
+        block = findBlockAfter(start);
+    }
+    while (block != -1 && nodes[block].start < end) {
+        merged.push_back(nodes[block].start);
+        start = std::min(start, nodes[block].start);
+        end = std::max(end, nodes[block].end);
+        block = findBlockAfter(nodes[block].start);
+    }
+    for (const auto& blockStart : merged) {
+        removeBlock(blockStart);
+    }
+
+    int node = newNode(start, end);
+    int left, right;
+    split(root_, start, left, right);
+    root_ = merge(merge(left, node), right);
+}
+
+void IntervalIndex::removeBlock(const TimePoint& start) {
+    int left, middle, right;
+    split(root_, start, left, middle);
+    split(middle, start + Duration(1), middle, right);
+    if (middle != -1) {
+        freeNodes_.push_back(middle);
+    }
+    root_ = merge(left, right);
+}
+
+int IntervalIndex::findBlockAtOrBefore(const TimePoint& time) const {
+    int best = -1;
+    int node = root_;
+    while (node != -1) {
+        if (nodes_[node].start <= time) {
+            best = node;
+            node = nodes_[node].right;
+        } else {
+            node = nodes_[node].left;
+        }
+    }
+    return best;
+}
+
+int IntervalIndex::findBlockAfter(const TimePoint& time) const {
+    int best = -1;
+    int node = root_;
+    while (node != -1) {
+        if (nodes_[node].start > time) {
+            best = node;
+            node = nodes_[node].left;
+        } else {
+            node = nodes_[node].right;
+        }
+    }
+    return best;
+}
+
+// In-order walk looking for the first pair of neighbouring blocks (p, q)
+// with p.start >= lo and q.start - p.end >= duration. Subtrees whose gaps
+// are all too small are skipped using their aggregates, so the walk only
+// follows O(log n) nodes.
+bool IntervalIndex::findGap(int node, const TimePoint& lo, const Duration& duration,
+                            Prev& prev, TimePoint& result) const {
+    if (node == -1) {
+        return false;
+    }
+
+    const Node& n = nodes_[node];
+    if (n.start < lo) {
+        prev = Prev{false, n.end};
+        return findGap(n.right, lo, duration, prev, result);
+    }
+    if (n.firstStart >= lo) {
+        bool boundary = prev.valid && n.firstStart - prev.end >= duration;
+        if (!boundary && n.maxGap < duration) {
+            prev = Prev{true, n.lastEnd};
+            return false;
+        }
+    }
+
+    if (findGap(n.left, lo, duration, prev, result)) {
+        return true;
+    }
+    if (prev.valid && n.start - prev.end >= duration) {
+        result = prev.end;
+        return true;
+    }
+    prev = Prev{true, n.end};
+    return findGap(n.right, lo, duration, prev, result);
+}
+
+// Balanced treap over blocks[first, last); depths[node] is filled in
+int IntervalIndex::build(const std::vector<Interval>& blocks, std::size_t first, std::size_t last,
+                         std::size_t depth, std::vector<std::size_t>& depths) {
+    if (first == last) {
+        return -1;
+    }
+    std::size_t middle = first + (last - first) / 2;
+    Node node;
+    node.start = blocks[middle].start;
+    node.end = blocks[middle].end;
+    int index = static_cast<int>(nodes_.size());
+    nodes_.push_back(node);
+    depths.push_back(depth);
+    int left = build(blocks, first, middle, depth + 1, depths);
+    int right = build(blocks, middle + 1, last, depth + 1, depths);
+    Node& n = nodes_[index];
+    n.left = left;
+    n.right = right;
+    pull(n);
+    return index;
+}
+
+int IntervalIndex::newNode(const TimePoint& start, const TimePoint& end) {
+    Node node;
+    node.start = start;
+    node.end = end;
+    node.priority = nextPriority();
+
+    int index;
+    if (!freeNodes_.empty()) {
+        index = freeNodes_.back();
+        freeNodes_.pop_back();
+        nodes_[index] = node;
+    } else {
+        index = static_cast<int>(nodes_.size());
+        nodes_.push_back(node);
+    }
+    pull(nodes_[index]);
+    return index;
+}
+
+void IntervalIndex::pull(Node& n) {
+    n.firstStart = n.start;
+    n.lastEnd = n.end;
+    n.maxGap = Duration::min();
+    if (n.left != -1) {
+        const Node& l = std::as_const(nodes_)[n.left];
+        n.firstStart = l.firstStart;
+        n.maxGap = std::max({n.maxGap, l.maxGap, n.start - l.lastEnd});
+    }
+    if (n.right != -1) {
+        const Node& r = std::as_const(nodes_)[n.right];
+        n.lastEnd = r.lastEnd;
+        n.maxGap = std::max({n.maxGap, r.maxGap, r.firstStart - n.end});
+    }
+}
+
+// Splits into blocks starting before `key` and blocks starting at or after it.
+// Node references stay valid across the recursion, since their pages are
+// already owned and nothing is added.
+void IntervalIndex::split(int node, const TimePoint& key, int& left, int& right) {
+    if (node == -1) {
+        left = right = -1;
+        return;
+    }
+    Node& n = nodes_[node];
+    if (n.start < key) {
+        int rest;
+        split(n.right, key, rest, right);
+        n.right = rest;
+        left = node;
+    } else {
+        int rest;
+        split(n.left, key, left, rest);
+        n.left = rest;
+        right = node;
+    }
+    pull(n);
+}
+
+int IntervalIndex::merge(int left, int right) {
+    if (left == -1) return right;
+    if (right == -1) return left;
+    Node& l = nodes_[left];
+    Node& r = nodes_[right];
+    if (l.priority > r.priority) {
+        l.right = merge(l.right, right);
+        pull(l);
+        return left;
+    }
+    r.left = merge(left, r.left);
+    pull(r);
+    return right;
+}
+
+std::uint32_t IntervalIndex::nextPriority() {
+    // xorshift32, good enough to keep the treap balanced
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    return seed_;
+}
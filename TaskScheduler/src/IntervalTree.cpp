@@ -0,0 +1,133 @@
+#include "../include/IntervalTree.hpp"
+#include <algorithm>
+
+IntervalTree::IntervalTree() : seed_(0x2545f491u) {}
+
+void IntervalTree::insert(Key key, const TimePoint& start, const TimePoint& end) {
+    erase(key);
+
+    Node node;
+    node.start = start;
+    node.end = end;
+    node.key = key;
+    node.priority = nextPriority();
+
+    int index;
+    if (!freeNodes_.empty()) {
+        index = freeNodes_.back();
+        freeNodes_.pop_back();
+        nodes_[index] = node;
+    } else {
+        index = static_cast<int>(nodes_.size());
+        nodes_.push_back(node);
+    }
+    pull(index);
+    index_[key] = index;
+
+    int left, right;
+    split(root_, start, key, left, right);
+    root_ = merge(merge(left, index), right);
+}
+
+bool IntervalTree::erase(Key key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return false;
+    }
+
+    int node = it->second;
+    index_.erase(it);
+
+    // Cut out exactly the node: everything before it, the node, everything after
+    int left, middle, right;
+    split(root_, nodes_[node].start, key, left, middle);
+    split(middle, nodes_[node].start, key + 1, middle, right);
+    root_ = merge(left, right);
+    freeNodes_.push_back(node);
+    return true;
+}
+
+void IntervalTree::clear() {
+    nodes_.clear();
+    freeNodes_.clear();
+    index_.clear();
+    root_ = -1;
+}
+
+void IntervalTree::overlapping(const TimePoint& from, const TimePoint& to,
+                               std::vector<Key>& out) const {
+    collect(root_, from, to, out);
+}
+
+void IntervalTree::collect(int node, const TimePoint& from, const TimePoint& to,
+                           std::vector<Key>& out) const {
+    // Nothing in this subtree ends after `from`
+    if (node == -1 || nodes_[node].maxEnd <= from) {
+        return;
+    }
+
+    const Node& n = nodes_[node];
+    collect(n.left, from, to, out);
+    if (n.start < to) {
+        if (n.end > from) {
+            out.push_back(n.key);
+        }
+        collect(n.right, from, to, out);
+    }
+}
+
+bool IntervalTree::less(const TimePoint& start, Key key, int node) const {
+    const Node& n = nodes_[node];
+    return n.start < start || (n.start == start && n.key < key);
+}
+
+void IntervalTree::pull(int node) {
+    Node& n = nodes_[node];
+    n.maxEnd = n.end;
+    if (n.left != -1) {
+        n.maxEnd = std::max(n.maxEnd, nodes_[n.left].maxEnd);
+    }
+    if (n.right != -1) {
+        n.maxEnd = std::max(n.maxEnd, nodes_[n.right].maxEnd);
+    }
+}
+
+// Splits into nodes ordered before (start, key) and the rest
+void IntervalTree::split(int node, const TimePoint& start, Key key, int& left, int& right) {
+    if (node == -1) {
+        left = right = -1;
+        return;
+    }
+    if (less(start, key, node)) {
+        int rest;
+        split(nodes_[node].right, start, key, rest, right);
+        nodes_[node].right = rest;
+        left = node;
+    } else {
+        int rest;
+        split(nodes_[node].left, start, key, left, rest);
+        nodes_[node].left = rest;
+        right = node;
+    }
+    pull(node);
+}
+
+int IntervalTree::merge(int left, int right) {
+    if (left == -1) return right;
+    if (right == -1) return left;
+    if (nodes_[left].priority > nodes_[right].priority) {
+        nodes_[left].right = merge(nodes_[left].right, right);
+        pull(left);
+        return left;
+    }
+    nodes_[right].left = merge(left, nodes_[right].left);
+    pull(right);
+    return right;
+}
+
+std::uint32_t IntervalTree::nextPriority() {
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    return seed_;
+}
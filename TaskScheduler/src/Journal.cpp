@@ -0,0 +1,730 @@
+#include "../include/Journal.hpp"
+#include "../include/TaskScheduler.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+enum class RecordType : std::uint8_t {
+    ADD_TASK = 1,
+    UPDATE_TASK,
+    REMOVE_TASK,
+    COMPLETE_TASK,
+    ADD_EVENT,
+    REMOVE_EVENT,
+    ADD_RECURRING_EVENT,
+    ADD_DEPENDENCY,
+    REMOVE_DEPENDENCY,
+    ADD_SERIES,
+    REMOVE_SERIES,
+    EXPAND_SERIES,
+    SETTINGS
+};
+
+constexpr std::uint64_t kNoLane = std::numeric_limits<std::uint64_t>::max();
+constexpr std::size_t kRecordHeader = 2 * sizeof(std::uint32_t);   // length, checksum
+
+// FNV-1a over a record body
+std::uint32_t checksum(const char* data, std::size_t size) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    }
+    return hash;
+}
+
+// Builds one record: header space first, filled in by finish()
+class RecordWriter {
+public:
+    explicit RecordWriter(RecordType type) : bytes_(kRecordHeader) { put(static_cast<std::uint8_t>(type)); }
+
+    template <typename T>
+    RecordWriter& put(T value) {
+        auto at = bytes_.size();
+        bytes_.resize(at + sizeof(T));
+        std::memcpy(bytes_.data() + at, &value, sizeof(T));
+        return *this;
+    }
+    RecordWriter& put(const std::string& text) {
+        put(static_cast<std::uint32_t>(text.size()));
+        bytes_.insert(bytes_.end(), text.begin(), text.end());
+        return *this;
+    }
+    RecordWriter& put(const std::chrono::system_clock::time_point& time) {
+        return put(static_cast<std::int64_t>(time.time_since_epoch().count()));
+    }
+    RecordWriter& put(const std::chrono::minutes& duration) {
+        return put(static_cast<std::int64_t>(duration.count()));
+    }
+    RecordWriter& put(const RecurrenceRule& rule) {
+        put(static_cast<std::uint8_t>(rule.frequency)).put(static_cast<std::uint32_t>(rule.interval))
+            .put(rule.weekdays).put(rule.until).put(static_cast<std::uint32_t>(rule.exceptions.size()));
+        for (const auto& exception : rule.exceptions) {
+            put(exception);
+        }
+        return *this;
+    }
+
+    const std::vector<char>& finish() {
+        auto length = static_cast<std::uint32_t>(bytes_.size() - kRecordHeader);
+        auto sum = checksum(bytes_.data() + kRecordHeader, length);
+        std::memcpy(bytes_.data(), &length, sizeof(length));
+        std::memcpy(bytes_.data() + sizeof(length), &sum, sizeof(sum));
+        return bytes_;
+    }
+
+private:
+    std::vector<char> bytes_;
+};
+
+// Reads the fields of one record body; any read past its end fails
+class RecordReader {
+public:
+    RecordReader(const char* data, std::size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (size_ - at_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data_ + at_, sizeof(T));
+        at_ += sizeof(T);
+        return true;
+    }
+    bool get(std::string& text) {
+        std::uint32_t length;
+        if (!get(length) || size_ - at_ < length) {
+            return false;
+        }
+        text.assign(data_ + at_, length);
+        at_ += length;
+        return true;
+    }
+    bool get(std::chrono::system_clock::time_point& time) {
+        std::int64_t ticks;
+        if (!get(ticks)) {
+            return false;
+        }
+        time = std::chrono::system_clock::time_point(std::chrono::system_clock::duration(ticks));
+        return true;
+    }
+    bool get(std::chrono::minutes& duration) {
+        std::int64_t minutes;
+        if (!get(minutes)) {
+            return false;
+        }
+        duration = std::chrono::minutes(minutes);
+        return true;
+    }
+    bool get(Priority& priority) {
+        std::uint8_t value;
+        if (!get(value) || value > static_cast<std::uint8_t>(Priority::URGENT)) {
+            return false;
+        }
+        priority = static_cast<Priority>(value);
+        return true;
+    }
+    bool get(bool& flag) {
+        std::uint8_t value;
+        if (!get(value) || value > 1) {
+            return false;
+        }
+        flag = value != 0;
+        return true;
+    }
+    bool get(RecurrenceRule& rule) {
+        std::uint8_t frequency;
+        std::uint32_t interval;
+        std::uint32_t exceptions;
+        if (!get(frequency) || frequency > static_cast<std::uint8_t>(RecurrenceRule::Frequency::WEEKLY) ||
+            !get(interval) || !get(rule.weekdays) || !get(rule.until) || !get(exceptions)) {
+            return false;
+        }
+        rule.frequency = static_cast<RecurrenceRule::Frequency>(frequency);
+        rule.interval = interval;
+        rule.exceptions.clear();
+        for (std::uint32_t i = 0; i < exceptions; ++i) {
+            std::chrono::system_clock::time_point exception;
+            if (!get(exception)) {
+                return false;
+            }
+            rule.exceptions.insert(exception);
+        }
+        return true;
+    }
+    bool done() const { return at_ == size_; }
+
+private:
+    const char* data_;
+    std::size_t size_;
+    std::size_t at_ = 0;
+};
+
+// Applies one record body; false if it does not parse
+bool apply(RecordReader& reader, TaskScheduler& scheduler) {
+    std::uint8_t type;
+    if (!reader.get(type)) {
+        return false;
+    }
+    switch (static_cast<RecordType>(type)) {
+        case RecordType::ADD_TASK: {
+            std::string name;
+            std::chrono::minutes duration;
+            Priority priority;
+            std::chrono::system_clock::time_point deadline;
+            bool completed;
+            if (!reader.get(name) || !reader.get(duration) || !reader.get(priority) || !reader.get(deadline) ||
+                !reader.get(completed) || !reader.done()) {
+                return false;
+            }
+            auto handle = scheduler.addTask(name, duration, priority, deadline);
+            if (completed) {
+                scheduler.completeTask(handle);
+            }
+            return true;
+        }
+        case RecordType::UPDATE_TASK: {
+            std::string taskName;
+            std::string name;
+            std::chrono::minutes duration;
+            Priority priority;
+            std::chrono::system_clock::time_point deadline;
+            bool completed;
+            if (!reader.get(taskName) || !reader.get(name) || !reader.get(duration) || !reader.get(priority) ||
+                !reader.get(deadline) || !reader.get(completed) || !reader.done()) {
+                return false;
+            }
+            auto task = std::make_shared<Task>(name, duration, priority, deadline);
+            task->setCompleted(completed);
+            scheduler.updateTask(taskName, task);
+            return true;
+        }
+        case RecordType::REMOVE_TASK:
+        case RecordType::COMPLETE_TASK: {
+            std::string name;
+            if (!reader.get(name) || !reader.done()) {
+                return false;
+            }
+            if (static_cast<RecordType>(type) == RecordType::REMOVE_TASK) {
+                scheduler.removeTask(name);
+            } else {
+                scheduler.completeTask(name);
+            }
+            return true;
+        }
+        case RecordType::ADD_EVENT: {
+            std::uint64_t id;
+            std::chrono::system_clock::time_point start;
+            std::chrono::system_clock::time_point end;
+            std::string description;
+            std::uint64_t lane;
+            if (!reader.get(id) || !reader.get(start) || !reader.get(end) || !reader.get(description) ||
+                !reader.get(lane) || !reader.done()) {
+                return false;
+            }
+            // Ids taken by events that are not journaled, such as ones
+            // dropped with their lane, are skipped so later removals find
+            // the right event
+            scheduler.skipEventIds(id);
+            if (lane == kNoLane) {
+                scheduler.addCalendarEvent(start, end, description);
+            } else {
+                scheduler.addCalendarEvent(start, end, description, static_cast<std::size_t>(lane));
+            }
+            return true;
+        }
+        case RecordType::REMOVE_EVENT: {
+            std::uint64_t id;
+            if (!reader.get(id) || !reader.done()) {
+                return false;
+            }
+            scheduler.removeCalendarEvent(id);
+            return true;
+        }
+        case RecordType::ADD_RECURRING_EVENT: {
+            std::uint64_t id;
+            std::chrono::system_clock::time_point start;
+            std::chrono::system_clock::time_point end;
+            std::string description;
+            RecurrenceRule rule;
+            std::uint64_t lane;
+            if (!reader.get(id) || !reader.get(start) || !reader.get(end) || !reader.get(description) ||
+                !reader.get(rule) || !reader.get(lane) || !reader.done()) {
+                return false;
+            }
+            scheduler.skipEventIds(id);
+            if (lane == kNoLane) {
+                scheduler.addRecurringEvent(start, end, description, rule);
+            } else {
+                scheduler.addRecurringEvent(start, end, description, rule, static_cast<std::size_t>(lane));
+            }
+            return true;
+        }
+        case RecordType::ADD_DEPENDENCY:
+        case RecordType::REMOVE_DEPENDENCY: {
+            std::string taskName;
+            std::string prerequisiteName;
+            if (!reader.get(taskName) || !reader.get(prerequisiteName) || !reader.done()) {
+                return false;
+            }
+            if (static_cast<RecordType>(type) == RecordType::ADD_DEPENDENCY) {
+                scheduler.addDependency(taskName, prerequisiteName);
+            } else {
+                scheduler.removeDependency(taskName, prerequisiteName);
+            }
+            return true;
+        }
+        case RecordType::ADD_SERIES: {
+            std::string name;
+            std::chrono::minutes duration;
+            Priority priority;
+            std::chrono::system_clock::time_point firstDue;
+            RecurrenceRule rule;
+            if (!reader.get(name) || !reader.get(duration) || !reader.get(priority) || !reader.get(firstDue) ||
+                !reader.get(rule) || !reader.done()) {
+                return false;
+            }
+            scheduler.addRecurringTask(name, duration, priority, firstDue, rule);
+            return true;
+        }
+        case RecordType::REMOVE_SERIES: {
+            std::string name;
+            if (!reader.get(name) || !reader.done()) {
+                return false;
+            }
+            scheduler.removeRecurringTask(name);
+            return true;
+        }
+        case RecordType::EXPAND_SERIES: {
+            // The occurrences themselves were journaled as tasks
+            std::string name;
+            std::chrono::system_clock::time_point until;
+            if (!reader.get(name) || !reader.get(until) || !reader.done()) {
+                return false;
+            }
+            scheduler.skipRecurringTask(name, until);
+            return true;
+        }
+        case RecordType::SETTINGS: {
+            std::uint64_t lanes;
+            std::uint8_t policy;
+            std::chrono::minutes granularity;
+            std::chrono::minutes horizon;
+            if (!reader.get(lanes) || !reader.get(policy) ||
+                policy > static_cast<std::uint8_t>(TaskScheduler::SchedulingPolicy::WEIGHTED_LATENESS) ||
+                !reader.get(granularity) || !reader.get(horizon) || !reader.done()) {
+                return false;
+            }
+            // Only what changed, as each setter invalidates the schedule
+            if (lanes != scheduler.getLaneCount()) {
+                scheduler.setLaneCount(static_cast<std::size_t>(lanes));
+            }
+            if (granularity != scheduler.getTimeGranularity()) {
+                scheduler.setTimeGranularity(granularity);
+            }
+            scheduler.setSchedulingPolicy(static_cast<TaskScheduler::SchedulingPolicy>(policy));
+            if (horizon != scheduler.getSchedulingHorizon()) {
+                scheduler.setSchedulingHorizon(horizon);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// Number in a "<prefix><N><suffix>" file name
+std::optional<std::uint64_t> fileNumber(const std::string& name, const std::string& prefix,
+                                        const std::string& suffix) {
+    if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return std::nullopt;
+    }
+    auto digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+    if (digits.find_first_not_of("0123456789") != std::string::npos) {
+        return std::nullopt;
+    }
+    return std::stoull(digits);
+}
+
+// Segment and snapshot numbers in a journal directory, ascending
+void listFiles(const std::string& directory, std::vector<std::uint64_t>& segments,
+               std::vector<std::uint64_t>& snapshots) {
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+        auto name = file.path().filename().string();
+        if (auto number = fileNumber(name, "journal-", ".log")) {
+            segments.push_back(*number);
+        } else if (auto number = fileNumber(name, "snapshot-", "")) {
+            snapshots.push_back(*number);
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    std::sort(snapshots.begin(), snapshots.end());
+}
+
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+}
+
+Journal::Journal(const std::string& directory) : Journal(directory, Options{}) {}
+
+Journal::Journal(const std::string& directory, const Options& options)
+    : directory_(directory)
+    , options_(options) {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+
+    std::vector<std::uint64_t> segments;
+    std::vector<std::uint64_t> snapshots;
+    listFiles(directory_, segments, snapshots);
+    std::uint64_t next = 0;
+    if (!segments.empty()) {
+        next = segments.back() + 1;
+    }
+    if (!snapshots.empty()) {
+        next = std::max(next, snapshots.back());
+    }
+    failed_ = !openSegment(next);
+    writer_ = std::thread(&Journal::run, this);
+}
+
+Journal::~Journal() {
+    if (compactor_.joinable()) {
+        compactor_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_one();
+    writer_.join();
+    if (segment_) {
+        std::fclose(segment_);
+    }
+}
+
+std::unique_ptr<TaskScheduler> Journal::recover() {
+    std::uint64_t end;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        end = segmentNumber_;
+    }
+    auto scheduler = fold(end);
+    scheduler->setJournal(this);
+    return scheduler;
+}
+
+Journal::Sequence Journal::logAddTask(const std::string& name, const std::chrono::minutes& duration,
+                                      Priority priority, const std::chrono::system_clock::time_point& deadline,
+                                      bool completed) {
+    RecordWriter record(RecordType::ADD_TASK);
+    record.put(name).put(duration).put(static_cast<std::uint8_t>(priority)).put(deadline)
+        .put(static_cast<std::uint8_t>(completed));
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logUpdateTask(const std::string& taskName, const std::string& name,
+                                         const std::chrono::minutes& duration, Priority priority,
+                                         const std::chrono::system_clock::time_point& deadline, bool completed) {
+    RecordWriter record(RecordType::UPDATE_TASK);
+    record.put(taskName).put(name).put(duration).put(static_cast<std::uint8_t>(priority)).put(deadline)
+        .put(static_cast<std::uint8_t>(completed));
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logRemoveTask(const std::string& name) {
+    RecordWriter record(RecordType::REMOVE_TASK);
+    record.put(name);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logCompleteTask(const std::string& name) {
+    RecordWriter record(RecordType::COMPLETE_TASK);
+    record.put(name);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logAddCalendarEvent(std::uint64_t id, const std::chrono::system_clock::time_point& start,
+                                               const std::chrono::system_clock::time_point& end,
+                                               const std::string& description, std::optional<std::size_t> lane) {
+    RecordWriter record(RecordType::ADD_EVENT);
+    record.put(id).put(start).put(end).put(description).put(lane ? static_cast<std::uint64_t>(*lane) : kNoLane);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logRemoveCalendarEvent(std::uint64_t id) {
+    RecordWriter record(RecordType::REMOVE_EVENT);
+    record.put(id);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logAddRecurringEvent(std::uint64_t id, const std::chrono::system_clock::time_point& start,
+                                                const std::chrono::system_clock::time_point& end,
+                                                const std::string& description, const RecurrenceRule& rule,
+                                                std::optional<std::size_t> lane) {
+    RecordWriter record(RecordType::ADD_RECURRING_EVENT);
+    record.put(id).put(start).put(end).put(description).put(rule)
+        .put(lane ? static_cast<std::uint64_t>(*lane) : kNoLane);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logAddDependency(const std::string& taskName, const std::string& prerequisiteName) {
+    RecordWriter record(RecordType::ADD_DEPENDENCY);
+    record.put(taskName).put(prerequisiteName);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logRemoveDependency(const std::string& taskName, const std::string& prerequisiteName) {
+    RecordWriter record(RecordType::REMOVE_DEPENDENCY);
+    record.put(taskName).put(prerequisiteName);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logAddRecurringTask(const std::string& name, const std::chrono::minutes& duration,
+                                               Priority priority,
+                                               const std::chrono::system_clock::time_point& firstDue,
+                                               const RecurrenceRule& rule) {
+    RecordWriter record(RecordType::ADD_SERIES);
+    record.put(name).put(duration).put(static_cast<std::uint8_t>(priority)).put(firstDue).put(rule);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logRemoveRecurringTask(const std::string& name) {
+    RecordWriter record(RecordType::REMOVE_SERIES);
+    record.put(name);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logExpandRecurringTask(const std::string& name,
+                                                  const std::chrono::system_clock::time_point& until) {
+    RecordWriter record(RecordType::EXPAND_SERIES);
+    record.put(name).put(until);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::logSettings(std::size_t lanes, std::uint8_t policy, const std::chrono::minutes& granularity,
+                                       const std::chrono::minutes& horizon) {
+    RecordWriter record(RecordType::SETTINGS);
+    record.put(static_cast<std::uint64_t>(lanes)).put(policy).put(granularity).put(horizon);
+    return append(record.finish());
+}
+
+Journal::Sequence Journal::lastSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return appended_;
+}
+
+bool Journal::waitDurable(Sequence sequence) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    committed_.wait(lock, [this, sequence] { return durable_.load() >= sequence || failed_; });
+    return durable_.load() >= sequence;
+}
+
+bool Journal::sync() {
+    return waitDurable(lastSequence());
+}
+
+bool Journal::compact() {
+    if (compacting_.exchange(true)) {
+        return false;
+    }
+    if (compactor_.joinable()) {
+        compactor_.join();
+    }
+
+    // Everything appended so far ends up below the new segment
+    std::uint64_t end;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        rollRequested_ = true;
+        workAvailable_.notify_one();
+        committed_.wait(lock, [this] { return !rollRequested_ || failed_; });
+        if (failed_) {
+            compacting_ = false;
+            return false;
+        }
+        end = segmentNumber_;
+    }
+    compactor_ = std::thread([this, end] {
+        compactionSucceeded_ = compactBelow(end);
+        compacting_ = false;
+    });
+    return true;
+}
+
+bool Journal::waitForCompaction() {
+    if (compactor_.joinable()) {
+        compactor_.join();
+    }
+    return compactionSucceeded_;
+}
+
+bool Journal::replay(const std::string& path, TaskScheduler& scheduler) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    std::vector<char> bytes;
+    char buffer[1 << 16];
+    std::size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + read);
+    }
+    std::fclose(file);
+
+    std::size_t at = 0;
+    while (bytes.size() - at >= kRecordHeader) {
+        std::uint32_t length;
+        std::uint32_t sum;
+        std::memcpy(&length, bytes.data() + at, sizeof(length));
+        std::memcpy(&sum, bytes.data() + at + sizeof(length), sizeof(sum));
+        at += kRecordHeader;
+        if (bytes.size() - at < length || checksum(bytes.data() + at, length) != sum) {
+            return false;
+        }
+        RecordReader reader(bytes.data() + at, length);
+        if (!apply(reader, scheduler)) {
+            return false;
+        }
+        at += length;
+    }
+    return at == bytes.size();
+}
+
+std::string Journal::segmentPath(std::uint64_t number) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "journal-%010llu.log", static_cast<unsigned long long>(number));
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+std::string Journal::snapshotPath(std::uint64_t number) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "snapshot-%010llu", static_cast<unsigned long long>(number));
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+bool Journal::openSegment(std::uint64_t number) {
+    if (segment_) {
+        std::fclose(segment_);
+    }
+    segment_ = std::fopen(segmentPath(number).c_str(), "ab");
+    segmentNumber_ = number;
+    segmentSize_ = 0;
+    return segment_ != nullptr;
+}
+
+Journal::Sequence Journal::append(const std::vector<char>& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool wake = pending_.empty();
+    pending_.insert(pending_.end(), record.begin(), record.end());
+    auto sequence = ++appended_;
+    if (wake) {
+        workAvailable_.notify_one();
+    }
+    return sequence;
+}
+
+// Group commit: every round writes and syncs whatever piled up during the
+// previous one
+void Journal::run() {
+    std::vector<char> batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        workAvailable_.wait(lock, [this] { return !pending_.empty() || rollRequested_ || stopping_; });
+        if (!pending_.empty() && !failed_) {
+            batch.swap(pending_);
+            Sequence upto = appended_;
+            lock.unlock();
+            bool written = std::fwrite(batch.data(), 1, batch.size(), segment_) == batch.size() &&
+                           syncFile(segment_);
+            lock.lock();
+            if (written) {
+                segmentSize_ += batch.size();
+                durable_ = upto;
+            } else {
+                failed_ = true;
+            }
+            batch.clear();
+        } else if (failed_) {
+            pending_.clear();
+        }
+        if (!failed_ && (rollRequested_ || segmentSize_ >= options_.segmentBytes)) {
+            failed_ = !openSegment(segmentNumber_ + 1);
+        }
+        rollRequested_ = false;
+        committed_.notify_all();
+        if (stopping_ && pending_.empty()) {
+            return;
+        }
+    }
+}
+
+// Loads the newest readable snapshot below `end` and replays the segments
+// from there up to `end`. A damaged record only ends its own segment:
+// later segments were started after recovery and carry on from what was
+// replayed.
+std::unique_ptr<TaskScheduler> Journal::fold(std::uint64_t end) {
+    std::lock_guard<std::mutex> lock(foldMutex_);
+    std::vector<std::uint64_t> segments;
+    std::vector<std::uint64_t> snapshots;
+    listFiles(directory_, segments, snapshots);
+
+    std::unique_ptr<TaskScheduler> scheduler;
+    std::uint64_t base = 0;
+    for (auto it = snapshots.rbegin(); it != snapshots.rend() && !scheduler; ++it) {
+        if (*it <= end && (scheduler = TaskScheduler::loadSnapshot(snapshotPath(*it)))) {
+            base = *it;
+        }
+    }
+    if (!scheduler) {
+        scheduler = std::make_unique<TaskScheduler>();
+    }
+    for (auto number : segments) {
+        if (number >= base && number < end) {
+            replay(segmentPath(number), *scheduler);
+        }
+    }
+    return scheduler;
+}
+
+bool Journal::compactBelow(std::uint64_t end) {
+    auto scheduler = fold(end);
+    if (!scheduler->saveSnapshot(snapshotPath(end))) {
+        return false;
+    }
+
+    // The new snapshot covers everything below it
+    std::lock_guard<std::mutex> lock(foldMutex_);
+    std::vector<std::uint64_t> segments;
+    std::vector<std::uint64_t> snapshots;
+    listFiles(directory_, segments, snapshots);
+    std::error_code error;
+    for (auto number : segments) {
+        if (number < end) {
+            std::filesystem::remove(segmentPath(number), error);
+        }
+    }
+    for (auto number : snapshots) {
+        if (number < end) {
+            std::filesystem::remove(snapshotPath(number), error);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+#include "../include/Recurrence.hpp"
+#include "../include/Bits.hpp"
+#include <algorithm>
+
+namespace {
+
+using Days = std::chrono::duration<std::int64_t, std::ratio<86400>>;
+constexpr Recurrence::Duration kDay = std::chrono::duration_cast<Recurrence::Duration>(Days(1));
+
+std::int64_t floorDiv(std::int64_t value, std::int64_t divisor) {
+    std::int64_t quotient = value / divisor;
+    return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+}
+
+}
+
+Recurrence::Recurrence(const TimePoint& first, const Duration& length, RecurrenceRule rule)
+    : first_(first), length_(std::max(length, Duration::zero())), rule_(std::move(rule)) {
+    rule_.interval = std::max(rule_.interval, 1u);
+
+    // 1970-01-01 was a Thursday
+    auto days = floorDiv(first.time_since_epoch().count(), kDay.count());
+    firstWeekday_ = static_cast<int>(((days + 4) % 7 + 7) % 7);
+    rule_.weekdays &= 0x7f;
+    if (rule_.weekdays == 0) {
+        rule_.weekdays = rule_.frequency == RecurrenceRule::Frequency::WEEKLY
+                             ? static_cast<std::uint8_t>(1u << firstWeekday_) : 0x7f;
+    }
+}
+
+std::optional<Recurrence::TimePoint> Recurrence::firstEndingAfter(const TimePoint& time) const {
+    auto day = occurrenceFrom(firstDayEndingAfter(time));
+    return day ? std::optional<TimePoint>(startOf(*day)) : std::nullopt;
+}
+
+std::optional<Recurrence::TimePoint> Recurrence::firstStartingAt(const TimePoint& time) const {
+    std::int64_t day = 0;
+    if (time > first_) {
+        auto gap = (time - first_).count();
+        day = gap / kDay.count() + (gap % kDay.count() != 0 ? 1 : 0);
+    }
+    auto found = occurrenceFrom(day);
+    return found ? std::optional<TimePoint>(startOf(*found)) : std::nullopt;
+}
+
+// Starts of the occurrences overlapping [from, to), in order
+void Recurrence::overlapping(const TimePoint& from, const TimePoint& to, std::vector<TimePoint>& starts) const {
+    for (auto day = occurrenceFrom(firstDayEndingAfter(from)); day && startOf(*day) < to;
+         day = occurrenceFrom(*day + 1)) {
+        starts.push_back(startOf(*day));
+    }
+}
+
+// Smallest day offset whose candidate occurrence ends after `time`
+std::int64_t Recurrence::firstDayEndingAfter(const TimePoint& time) const {
+    if (!(time > first_)) {
+        return 0;
+    }
+    auto gap = (time - first_) - length_;
+    return gap < Duration::zero() ? 0 : gap.count() / kDay.count() + 1;
+}
+
+// First day offset at or after `day` that holds an occurrence
+std::optional<std::int64_t> Recurrence::occurrenceFrom(std::int64_t day) const {
+    const std::int64_t lastDay = (TimePoint::max() - first_).count() / kDay.count();
+    const std::int64_t interval = rule_.interval;
+
+    while (day <= lastDay) {
+        if (rule_.frequency == RecurrenceRule::Frequency::DAILY) {
+            if (day % interval != 0) {
+                day += interval - day % interval;
+                continue;
+            }
+            if (!(rule_.weekdays >> ((firstWeekday_ + day) % 7) & 1)) {
+                ++day;
+                continue;
+            }
+        } else {
+            // Weeks run Sunday to Saturday, counted from the first occurrence's week
+            std::int64_t anchor = firstWeekday_ + day;
+            std::int64_t week = anchor / 7;
+            int weekday = static_cast<int>(anchor % 7);
+            if (week % interval != 0) {
+                day = (week / interval + 1) * interval * 7 - firstWeekday_;
+                continue;
+            }
+            unsigned later = rule_.weekdays & (0x7fu << weekday) & 0x7fu;
+            if (later == 0) {
+                day += 7 - weekday;
+                continue;
+            }
+            day += countTrailingZeros(later) - weekday;
+        }
+
+        auto start = startOf(day);
+        if (start >= rule_.until) {
+            return std::nullopt;
+        }
+        if (rule_.exceptions.count(start) == 0) {
+            return day;
+        }
+        ++day;
+    }
+    return std::nullopt;
+}
+
+Recurrence::TimePoint Recurrence::startOf(std::int64_t day) const {
+    return first_ + kDay * day;
+}
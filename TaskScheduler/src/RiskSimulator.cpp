@@ -0,0 +1,123 @@
+#include "../include/RiskSimulator.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// splitmix64 finalizer
+std::uint64_t mix(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+constexpr std::uint64_t kGolden = 0x9E3779B97F4A7C15ull;
+
+double toUnit(std::uint64_t bits) {
+    return (bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Value at `rank` (0..1) of an unsorted sample, reordering it
+float percentile(std::vector<float>& values, double rank) {
+    auto at = static_cast<std::size_t>(rank * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + at, values.end());
+    return values[at];
+}
+
+}
+
+RiskSimulator::RiskSimulator(const std::vector<Job>& jobs,
+                             const std::vector<std::vector<std::uint32_t>>& predecessors) {
+    std::size_t n = jobs.size();
+    earliest_.reserve(n);
+    due_.reserve(n);
+    low_.reserve(n);
+    high_.reserve(n);
+    split_.reserve(n);
+    lowArea_.reserve(n);
+    highArea_.reserve(n);
+    firstPredecessor_.reserve(n + 1);
+    for (std::size_t j = 0; j < n; ++j) {
+        const auto& job = jobs[j];
+        double span = job.high - job.low;
+        earliest_.push_back(job.earliestStart);
+        due_.push_back(job.due);
+        low_.push_back(job.low);
+        high_.push_back(job.high);
+        split_.push_back(span > 0 ? (job.mode - job.low) / span : 1.0);
+        lowArea_.push_back(span * (job.mode - job.low));
+        highArea_.push_back(span * (job.high - job.mode));
+        firstPredecessor_.push_back(static_cast<std::uint32_t>(predecessors_.size()));
+        predecessors_.insert(predecessors_.end(), predecessors[j].begin(), predecessors[j].end());
+    }
+    firstPredecessor_.push_back(static_cast<std::uint32_t>(predecessors_.size()));
+}
+
+RiskSimulator::Tally RiskSimulator::makeTally() const {
+    return Tally{std::vector<double>(size()), std::vector<std::uint32_t>(size(), 0)};
+}
+
+void RiskSimulator::run(std::uint64_t first, std::uint64_t last, std::uint64_t seed, Tally& tally,
+                        float* samples, std::uint64_t sampleCount) const {
+    std::size_t n = size();
+    double* finish = tally.finish.data();
+    std::uint32_t* misses = tally.misses.data();
+    for (std::uint64_t pass = first; pass < last; ++pass) {
+        // Job j draws from the splitmix64 stream of this pass at position j
+        std::uint64_t key = mix(seed + mix(pass + kGolden));
+        for (std::size_t j = 0; j < n; ++j) {
+            double start = earliest_[j];
+            for (auto p = firstPredecessor_[j]; p < firstPredecessor_[j + 1]; ++p) {
+                start = std::max(start, finish[predecessors_[p]]);
+            }
+
+            // Inverse CDF of the triangular distribution
+            double u = toUnit(mix(key + (j + 1) * kGolden));
+            double duration = u < split_[j] ? low_[j] + std::sqrt(u * lowArea_[j])
+                                            : high_[j] - std::sqrt((1.0 - u) * highArea_[j]);
+            finish[j] = start + duration;
+            misses[j] += finish[j] > due_[j];
+        }
+        if (pass < sampleCount) {
+            std::copy(finish, finish + n, samples + pass * n);
+        }
+    }
+}
+
+RiskSimulator::Result RiskSimulator::summarize(const std::vector<Tally>& tallies, std::uint64_t passes,
+                                               const std::vector<float>& samples,
+                                               std::uint64_t sampleCount) const {
+    std::size_t n = size();
+    Result result;
+    result.jobs.resize(n);
+    if (n == 0 || passes == 0) {
+        return result;
+    }
+    sampleCount = std::min(sampleCount, passes);
+
+    std::vector<float> column(sampleCount);
+    for (std::size_t j = 0; j < n; ++j) {
+        std::uint64_t missed = 0;
+        for (const auto& tally : tallies) {
+            missed += tally.misses[j];
+        }
+        result.jobs[j].missProbability = static_cast<double>(missed) / passes;
+        if (sampleCount == 0) {
+            continue;
+        }
+        for (std::uint64_t s = 0; s < sampleCount; ++s) {
+            column[s] = samples[s * n + j];
+        }
+        result.jobs[j].p50Finish = percentile(column, 0.5);
+        result.jobs[j].p90Finish = percentile(column, 0.9);
+    }
+    if (sampleCount == 0) {
+        return result;
+    }
+    for (std::uint64_t s = 0; s < sampleCount; ++s) {
+        column[s] = *std::max_element(samples.begin() + s * n, samples.begin() + (s + 1) * n);
+    }
+    result.p50Finish = percentile(column, 0.5);
+    result.p90Finish = percentile(column, 0.9);
+    return result;
+}
@@ -0,0 +1,116 @@
+#include "../include/SequenceOptimizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// splitmix64, good enough to drive the moves and cheap to seed per run
+struct Random {
+    std::uint64_t state;
+
+    std::uint64_t next() {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// Moves between clock checks and temperature updates
+constexpr std::uint64_t kMovesPerCheck = 1024;
+
+// Final temperature as a fraction of the initial one
+constexpr double kCooling = 1e-3;
+
+}
+
+SequenceOptimizer::SequenceOptimizer(std::vector<Job> jobs) : jobs_(std::move(jobs)) {}
+
+std::int64_t SequenceOptimizer::cost(const std::vector<std::uint32_t>& order) const {
+    std::int64_t completion = 0;
+    std::int64_t total = 0;
+    for (auto job : order) {
+        completion += jobs_[job].duration;
+        total += tardiness(job, completion);
+    }
+    return total;
+}
+
+std::vector<std::uint32_t> SequenceOptimizer::dueOrder() const {
+    std::vector<std::uint32_t> order(jobs_.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [this](std::uint32_t a, std::uint32_t b) { return jobs_[a].due < jobs_[b].due; });
+    return order;
+}
+
+SequenceOptimizer::Result SequenceOptimizer::anneal(std::vector<std::uint32_t> order,
+                                                    std::chrono::nanoseconds budget,
+                                                    std::uint64_t seed) const {
+    Result best;
+    best.order = order;
+    best.cost = cost(order);
+    std::size_t n = order.size();
+    if (n < 2) {
+        return best;
+    }
+
+    Random random{seed};
+
+    // completion[i] is when the job at position i finishes
+    std::vector<std::int64_t> completion(n);
+    std::int64_t current = best.cost;
+    std::int64_t total = 0;
+    double meanDuration = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        total += jobs_[order[i]].duration;
+        completion[i] = total;
+        meanDuration += jobs_[order[i]].duration;
+    }
+    meanDuration /= n;
+
+    // Start hot enough to accept a typical uphill swap about half the time
+    const double initialTemperature = std::max(1.0, meanDuration * 1.5);
+    double temperature = initialTemperature;
+    auto start = std::chrono::steady_clock::now();
+
+    while (best.cost > 0) {
+        for (std::uint64_t m = 0; m < kMovesPerCheck; ++m) {
+            // Swap positions i and i + 1
+            std::size_t i = random.next() % (n - 1);
+            auto a = order[i];
+            auto b = order[i + 1];
+            std::int64_t before = i ? completion[i - 1] : 0;
+            std::int64_t end = completion[i + 1];
+            std::int64_t delta = tardiness(b, before + jobs_[b].duration) + tardiness(a, end)
+                               - tardiness(a, completion[i]) - tardiness(b, end);
+
+            if (delta <= 0 || random.uniform() < std::exp(-delta / temperature)) {
+                order[i] = b;
+                order[i + 1] = a;
+                completion[i] = before + jobs_[b].duration;
+                current += delta;
+            }
+        }
+        best.moves += kMovesPerCheck;
+
+        // Only copy the order at checkpoints so improvements stay cheap
+        if (current < best.cost) {
+            best.order = order;
+            best.cost = current;
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed >= budget) {
+            break;
+        }
+        double progress = std::chrono::duration<double>(elapsed) / std::chrono::duration<double>(budget);
+        temperature = initialTemperature * std::pow(kCooling, progress);
+    }
+    return best;
+}
@@ -0,0 +1,253 @@
+#include "../include/Snapshot.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'T', 'S', 'K', 'S', 'N', 'A', 'P', '\0'};
+constexpr std::uint32_t kByteOrder = 0x01020304;
+constexpr std::size_t kAlignment = 8;
+
+static_assert(sizeof(Snapshot::Header) % kAlignment == 0, "sections must start aligned");
+static_assert(sizeof(Snapshot::EventRecord) % kAlignment == 0, "records must stay aligned");
+static_assert(sizeof(Snapshot::SeriesRecord) % kAlignment == 0, "records must stay aligned");
+
+std::uint64_t ticksPerSecond() {
+    using Period = std::chrono::system_clock::period;
+    return static_cast<std::uint64_t>(Period::den / Period::num);
+}
+
+std::uint64_t alignUp(std::uint64_t offset) {
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Word-wise multiply-xorshift hash; sections are padded with zeros to
+// whole words, so hashing section by section matches hashing the file
+class Checksum {
+public:
+    void add(const void* data, std::size_t bytes) {
+        const char* bytesIn = static_cast<const char*>(data);
+        for (; bytes >= 8; bytes -= 8, bytesIn += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, bytesIn, 8);
+            mix(word);
+        }
+        if (bytes > 0) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, bytesIn, bytes);
+            mix(word);
+        }
+    }
+    std::uint64_t value() const { return hash_ ^ (hash_ >> 29); }
+
+private:
+    std::uint64_t hash_ = 0xcbf29ce484222325;
+
+    void mix(std::uint64_t word) {
+        hash_ = (hash_ ^ word) * 0x9e3779b97f4a7c15;
+        hash_ ^= hash_ >> 32;
+    }
+};
+
+std::uint64_t headerChecksum(Snapshot::Header header, Checksum checksum) {
+    header.checksum = 0;
+    checksum.add(&header, sizeof(header));
+    return checksum.value();
+}
+
+bool writeAll(std::FILE* file, const void* data, std::size_t size) {
+    return size == 0 || std::fwrite(data, 1, size, file) == size;
+}
+
+// Flushes the file down to the disk
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Makes a rename within the directory durable
+void syncDirectory(const std::string& path) {
+#ifndef _WIN32
+    auto slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
+
+bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    // rename() does not replace existing files on Windows
+    std::remove(to.c_str());
+#endif
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+}
+
+std::uint32_t Snapshot::elementSize(Section section) {
+    switch (section) {
+        case Section::TASK_NAMES:
+        case Section::PRIORITIES:
+        case Section::LIVE:
+        case Section::TEXT:
+            return 1;
+        case Section::BUCKETS:
+        case Section::CRITICAL_PATH:
+            return sizeof(std::uint32_t);
+        case Section::PLACEMENTS: return sizeof(Placement);
+        case Section::EVENTS: return sizeof(EventRecord);
+        case Section::SERIES: return sizeof(SeriesRecord);
+        case Section::PREREQUISITES:
+        case Section::DEPENDENTS:
+            return sizeof(Edge);
+        case Section::TIMINGS: return sizeof(Timing);
+        default: return sizeof(std::uint64_t);
+    }
+}
+
+std::unique_ptr<Snapshot> Snapshot::open(const std::string& path) {
+    std::unique_ptr<Snapshot> snapshot(new Snapshot());
+#ifdef _WIN32
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return nullptr;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    if (size < static_cast<long>(sizeof(Header))) {
+        std::fclose(file);
+        return nullptr;
+    }
+    snapshot->buffer_.resize((static_cast<std::size_t>(size) + 7) / 8);
+    bool read = std::fread(snapshot->buffer_.data(), 1, size, file) == static_cast<std::size_t>(size);
+    std::fclose(file);
+    if (!read) {
+        return nullptr;
+    }
+    snapshot->data_ = reinterpret_cast<const char*>(snapshot->buffer_.data());
+    snapshot->size_ = static_cast<std::size_t>(size);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        return nullptr;
+    }
+    auto size = static_cast<std::size_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+    // Loading reads every section front to back
+    madvise(mapped, size, MADV_WILLNEED);
+    snapshot->data_ = static_cast<const char*>(mapped);
+    snapshot->size_ = size;
+#endif
+
+    const Header& header = snapshot->header();
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.byteOrder != kByteOrder || header.ticksPerSecond != ticksPerSecond() ||
+        header.fileSize != snapshot->size_) {
+        return nullptr;
+    }
+    Checksum body;
+    body.add(snapshot->data_ + sizeof(Header), snapshot->size_ - sizeof(Header));
+    if (headerChecksum(header, body) != header.checksum) {
+        return nullptr;
+    }
+    for (std::size_t s = 0; s < kSectionCount; ++s) {
+        const auto& entry = header.sections[s];
+        if (entry.elementSize != elementSize(static_cast<Section>(s)) || entry.offset % kAlignment != 0 ||
+            entry.offset > snapshot->size_ || entry.count > (snapshot->size_ - entry.offset) / entry.elementSize) {
+            return nullptr;
+        }
+    }
+    return snapshot;
+}
+
+Snapshot::~Snapshot() {
+#ifndef _WIN32
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+SnapshotWriter::SnapshotWriter() : header_{} {
+    std::memcpy(header_.magic, kMagic, sizeof(kMagic));
+    header_.version = Snapshot::kVersion;
+    header_.byteOrder = kByteOrder;
+    header_.ticksPerSecond = ticksPerSecond();
+}
+
+bool SnapshotWriter::write(const std::string& path) {
+    // Lay the sections out back to back behind the header
+    std::uint64_t offset = sizeof(Snapshot::Header);
+    for (std::size_t s = 0; s < Snapshot::kSectionCount; ++s) {
+        const auto& pending = sections_[s];
+        auto elementSize = Snapshot::elementSize(static_cast<Snapshot::Section>(s));
+        if (pending.count > 0 && pending.elementSize != elementSize) {
+            return false;
+        }
+        auto& entry = header_.sections[s];
+        entry.offset = offset;
+        entry.count = pending.count;
+        entry.elementSize = elementSize;
+        offset = alignUp(offset + pending.count * elementSize);
+    }
+    header_.fileSize = offset;
+    Checksum body;
+    for (std::size_t s = 0; s < Snapshot::kSectionCount; ++s) {
+        const auto& entry = header_.sections[s];
+        body.add(sections_[s].data, static_cast<std::size_t>(entry.count * entry.elementSize));
+    }
+    header_.checksum = headerChecksum(header_, body);
+
+    std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    static const char padding[kAlignment] = {};
+    bool written = writeAll(file, &header_, sizeof(header_));
+    for (std::size_t s = 0; s < Snapshot::kSectionCount && written; ++s) {
+        const auto& entry = header_.sections[s];
+        std::size_t bytes = static_cast<std::size_t>(entry.count * entry.elementSize);
+        written = writeAll(file, sections_[s].data, bytes) &&
+                  writeAll(file, padding, static_cast<std::size_t>(alignUp(bytes) - bytes));
+    }
+    written = written && syncFile(file);
+    if (std::fclose(file) != 0 || !written || !replaceFile(temporary, path)) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    syncDirectory(path);
+    return true;
+}
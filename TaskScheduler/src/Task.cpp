@@ -10,4 +10,52 @@ Task::Task(const std::string& name,
     , deadline_(deadline)
     , completed_(false)
     , scheduled_time_(std::chrono::system_clock::time_point::min()) {
-} 
\ No newline at end of file
+}
+
+void Task::setScheduledTime(const std::chrono::system_clock::time_point& time) {
+    if (store_) {
+        store_->setScheduledTime(handle_, time);
+    } else {
+        scheduled_time_ = time;
+    }
+}
+
+void Task::setCompleted(bool completed) {
+    if (store_) {
+        store_->changeCompleted(handle_, completed);
+    } else {
+        completed_ = completed;
+    }
+}
+
+void Task::setPriority(Priority priority) {
+    if (store_) {
+        store_->changePriority(handle_, priority);
+    } else {
+        priority_ = priority;
+    }
+}
+
+void Task::setPayload(std::function<void()> payload) {
+    if (store_) {
+        store_->setPayload(handle_, std::move(payload));
+    } else {
+        payload_ = std::move(payload);
+    }
+}
+
+// Takes a copy of the current values so the task keeps working on its own
+void Task::detach() {
+    if (!store_) {
+        return;
+    }
+    name_ = store_->name(handle_);
+    duration_ = store_->duration(handle_);
+    priority_ = store_->priority(handle_);
+    deadline_ = store_->deadline(handle_);
+    completed_ = store_->isCompleted(handle_);
+    scheduled_time_ = store_->scheduledTime(handle_);
+    payload_ = store_->payload(handle_);
+    store_ = nullptr;
+    handle_ = TaskStore::kInvalidHandle;
+}
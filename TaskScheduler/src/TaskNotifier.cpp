@@ -0,0 +1,113 @@
+#include "../include/TaskNotifier.hpp"
+#include <algorithm>
+#include <utility>
+
+TaskNotifier::TaskNotifier(Callback callback, std::chrono::milliseconds resolution)
+    : callback_(std::move(callback)),
+      resolution_(std::max<std::chrono::system_clock::duration>(resolution, std::chrono::system_clock::duration(1))),
+      wheel_(floorTick(std::chrono::system_clock::now())),
+      thread_(&TaskNotifier::run, this) {}
+
+TaskNotifier::~TaskNotifier() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void TaskNotifier::arm(Handle handle, Event event, const std::chrono::system_clock::time_point& time) {
+    auto which = static_cast<std::size_t>(event);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (handle >= timers_.size()) {
+        timers_.resize(handle + 1);
+    }
+    auto& timers = timers_[handle];
+    if (timers.armed[which] != 0) {
+        wheel_.cancel(timers.armed[which]);
+        timers.armed[which] = 0;
+    }
+    // No deadline, or the event this timer would repeat
+    auto tick = ceilTick(time);
+    if (time == std::chrono::system_clock::time_point::max() || tick == timers.fired[which]) {
+        return;
+    }
+    timers.armed[which] = wheel_.arm(tick, (std::uint64_t(handle) << 1) | which);
+    if (tick < wakeAt_) {
+        wake_.notify_one();
+    }
+}
+
+void TaskNotifier::cancel(Handle handle, Event event) {
+    auto which = static_cast<std::size_t>(event);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (handle < timers_.size() && timers_[handle].armed[which] != 0) {
+        wheel_.cancel(timers_[handle].armed[which]);
+        timers_[handle].armed[which] = 0;
+    }
+}
+
+void TaskNotifier::forget(Handle handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (handle < timers_.size()) {
+        for (auto id : timers_[handle].armed) {
+            if (id != 0) {
+                wheel_.cancel(id);
+            }
+        }
+        timers_[handle] = Timers{};
+    }
+}
+
+std::size_t TaskNotifier::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wheel_.size();
+}
+
+TimingWheel::Tick TaskNotifier::floorTick(const std::chrono::system_clock::time_point& time) const {
+    auto since = time.time_since_epoch();
+    auto tick = since / resolution_;
+    return since % resolution_ < std::chrono::system_clock::duration(0) ? tick - 1 : tick;
+}
+
+TimingWheel::Tick TaskNotifier::ceilTick(const std::chrono::system_clock::time_point& time) const {
+    auto since = time.time_since_epoch();
+    auto tick = since / resolution_;
+    return since % resolution_ > std::chrono::system_clock::duration(0) ? tick + 1 : tick;
+}
+
+void TaskNotifier::run() {
+    auto lastTick = std::chrono::system_clock::duration::max() / resolution_;
+    std::vector<std::pair<Handle, Event>> due;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        wakeAt_ = kNever;
+        wheel_.advance(floorTick(std::chrono::system_clock::now()),
+                       [&](std::uint64_t payload, TimingWheel::Tick tick) {
+                           auto handle = static_cast<Handle>(payload >> 1);
+                           auto which = payload & 1;
+                           timers_[handle].armed[which] = 0;
+                           timers_[handle].fired[which] = tick;
+                           due.emplace_back(handle, static_cast<Event>(which));
+                       });
+        if (!due.empty()) {
+            lock.unlock();
+            for (const auto& [handle, event] : due) {
+                callback_(handle, event);
+            }
+            due.clear();
+            lock.lock();
+            continue;
+        }
+
+        auto next = wheel_.nextExpiry();
+        if (next && *next < lastTick) {
+            wakeAt_ = *next;
+            wake_.wait_until(lock, std::chrono::system_clock::time_point(resolution_ * *next));
+        } else {
+            wakeAt_ = std::numeric_limits<TimingWheel::Tick>::max();
+            wake_.wait(lock);
+        }
+    }
+}
@@ -1,147 +1,2257 @@
 #include "../include/TaskScheduler.hpp"
 #include <algorithm>
+#include <functional>
+#include <queue>
+#include <ctime>
 #include <iostream>
+#include <iterator>
+#include <numeric>
+#include <utility>
 
-TaskScheduler::TaskScheduler() {}
+namespace {
+
+using Days = std::chrono::duration<std::int64_t, std::ratio<86400>>;
+
+// How far ahead recurring tasks are created when no horizon is set
+constexpr std::chrono::hours kRecurrenceLookahead{24 * 28};
+
+// Cap on the recurrence period a slot search waits out before giving up
+constexpr Days kLongestPeriod{7 * 52 * 100};
+
+std::tm toLocalTime(std::time_t time) {
+    std::tm result{};
+#ifdef _WIN32
+    localtime_s(&result, &time);
+#else
+    localtime_r(&time, &result);
+#endif
+    return result;
+}
+
+std::string toUtcDate(const std::chrono::system_clock::time_point& time) {
+    std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    std::tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+    char text[16];
+    std::strftime(text, sizeof(text), "%Y-%m-%d", &utc);
+    return text;
+}
+
+std::int64_t toTicks(const std::chrono::system_clock::time_point& time) {
+    return time.time_since_epoch().count();
+}
+
+std::chrono::system_clock::time_point fromTicks(std::int64_t ticks) {
+    return std::chrono::system_clock::time_point(std::chrono::system_clock::duration(ticks));
+}
+
+Snapshot::RuleRecord saveRule(const RecurrenceRule& rule, std::vector<std::int64_t>& exceptions) {
+    Snapshot::RuleRecord record{};
+    record.until = toTicks(rule.until);
+    record.firstException = exceptions.size();
+    record.exceptionCount = rule.exceptions.size();
+    record.interval = rule.interval;
+    record.frequency = static_cast<std::uint8_t>(rule.frequency);
+    record.weekdays = rule.weekdays;
+    for (const auto& skipped : rule.exceptions) {
+        exceptions.push_back(toTicks(skipped));
+    }
+    return record;
+}
+
+std::optional<RecurrenceRule> loadRule(const Snapshot::RuleRecord& record,
+                                       const Snapshot::Column<std::int64_t>& exceptions) {
+    if (record.frequency > static_cast<std::uint8_t>(RecurrenceRule::Frequency::WEEKLY) ||
+        record.firstException > exceptions.size() ||
+        record.exceptionCount > exceptions.size() - record.firstException) {
+        return std::nullopt;
+    }
+    RecurrenceRule rule;
+    rule.frequency = static_cast<RecurrenceRule::Frequency>(record.frequency);
+    rule.interval = record.interval;
+    rule.weekdays = record.weekdays;
+    rule.until = fromTicks(record.until);
+    for (std::uint64_t i = 0; i < record.exceptionCount; ++i) {
+        rule.exceptions.insert(fromTicks(exceptions[record.firstException + i]));
+    }
+    return rule;
+}
+
+std::optional<std::string> loadText(const Snapshot::Column<char>& text, std::uint64_t offset, std::uint64_t length) {
+    if (offset > text.size() || length > text.size() - offset) {
+        return std::nullopt;
+    }
+    return std::string(text.data() + offset, length);
+}
+
+// Weight of a priority in the weighted lateness policy and report
+int priorityWeight(Priority priority) {
+    return 1 << static_cast<int>(priority);
+}
+
+}
+
+TaskScheduler::TaskScheduler() : store_(std::make_unique<TaskStore>()), lanes_(std::in_place, 1, Lane(std::chrono::minutes(0))) {
+    watchStore();
+}
+
+std::unique_ptr<TaskScheduler> TaskScheduler::fork() const {
+    auto copy = std::make_unique<TaskScheduler>();
+    copy->store_ = store_->fork();
+    copy->watchStore();
+    copy->entries_ = entries_;
+    copy->nameIndex_ = nameIndex_;
+    copy->buckets_ = buckets_;
+    copy->holes_ = holes_;
+    copy->calendar_events_ = calendar_events_;
+    copy->lanes_ = lanes_;
+    copy->granularity_ = granularity_;
+    copy->laneEvents_ = laneEvents_;
+    copy->taskSeries_ = taskSeries_;
+    copy->links_ = links_;
+    copy->dependencyCount_ = dependencyCount_;
+    copy->dependencyCycle_ = dependencyCycle_;
+    copy->timings_ = timings_;
+    copy->criticalPath_ = criticalPath_;
+    copy->estimates_ = estimates_;
+    copy->policy_ = policy_;
+    copy->deadlines_ = deadlines_;
+    copy->utcOffset_ = utcOffset_;
+    copy->dirty_ = dirty_;
+    copy->horizon_ = horizon_;
+    copy->horizonEnd_ = horizonEnd_;
+    copy->frontier_ = frontier_;
+    copy->nextTicket_ = nextTicket_;
+    return copy;
+}
+
+bool TaskScheduler::saveSnapshot(const std::string& path) const {
+    using Section = Snapshot::Section;
+    SnapshotWriter writer;
+    auto& header = writer.header();
+    header.taskCapacity = store_->capacity();
+    for (std::size_t b = 0; b < kPriorityCount; ++b) {
+        header.bucketSizes[b] = buckets_[b].size() - holes_[b];
+    }
+    header.nextEventId = calendar_events_->nextId();
+    header.laneCount = static_cast<std::uint32_t>(lanes_->size());
+    header.policy = static_cast<std::uint32_t>(policy_);
+    header.granularity = granularity_.count();
+    header.horizon = horizon_.count();
+    header.horizonEnd = toTicks(horizonEnd_);
+    header.hasUtcOffset = utcOffset_.has_value();
+    header.utcOffset = utcOffset_ ? utcOffset_->count() : 0;
+    // Buckets are saved without holes
+    header.hasDirty = dirty_.has_value();
+    if (dirty_) {
+        header.dirty[0] = dirty_->bucket;
+        header.dirty[1] = liveBefore(*dirty_);
+    }
+    header.hasFrontier = frontier_.has_value();
+    if (frontier_) {
+        header.frontier[0] = frontier_->bucket;
+        header.frontier[1] = liveBefore(*frontier_);
+    }
+    header.dependencyCycle = dependencyCycle_;
+    store_->save(writer);
+    
+    // Scheduling order and per task state
+    std::vector<Snapshot::Placement> placements(store_->capacity(), Snapshot::Placement{});
+    for (std::size_t handle = 0; handle < placements.size() && handle < entries_.size(); ++handle) {
+        const auto& entry = entries_[handle];
+        placements[handle].placedAt = toTicks(entry.placedAt);
+        placements[handle].lane = entry.lane;
+        placements[handle].flags = static_cast<std::uint8_t>((entry.placed ? Snapshot::PLACED : 0) |
+                                                             (entry.deferred ? Snapshot::DEFERRED : 0) |
+                                                             (entry.deadlineIndexed ? Snapshot::DEADLINE_INDEXED : 0));
+    }
+    std::vector<std::uint32_t> order;
+    order.reserve(nameIndex_.size());
+    for (const auto& bucket : buckets_) {
+        std::copy_if(bucket.begin(), bucket.end(), std::back_inserter(order),
+                     [](TaskHandle handle) { return handle != TaskStore::kInvalidHandle; });
+    }
+    writer.add(Section::PLACEMENTS, std::move(placements));
+    writer.add(Section::BUCKETS, std::move(order));
+    
+    // Calendar events and task series, by id and name
+    std::vector<Snapshot::EventRecord> events;
+    std::vector<Snapshot::SeriesRecord> series;
+    std::vector<char> text;
+    std::vector<std::int64_t> exceptions;
+    auto ids = calendar_events_->overlapping(std::chrono::system_clock::time_point::min(),
+                                             std::chrono::system_clock::time_point::max());
+    for (const auto& recurring : calendar_events_->recurring()) {
+        ids.push_back(recurring.first);
+    }
+    std::sort(ids.begin(), ids.end());
+    for (auto id : ids) {
+        const CalendarEvent* event = calendar_events_->find(id);
+        Snapshot::EventRecord record{};
+        record.id = id;
+        record.start = toTicks(event->start);
+        record.end = toTicks(event->end);
+        record.textOffset = text.size();
+        record.textLength = event->description.size();
+        text.insert(text.end(), event->description.begin(), event->description.end());
+        auto laneEvent = laneEvents_->find(id);
+        record.lane = laneEvent != laneEvents_->end() ? static_cast<std::uint32_t>(laneEvent->second)
+                                                      : Snapshot::kNoLane;
+        if (auto recurrence = calendar_events_->findRecurrence(id)) {
+            record.recurring = 1;
+            record.rule = saveRule(recurrence->rule(), exceptions);
+        }
+        events.push_back(record);
+    }
+    for (const auto& [name, taskSeries] : *taskSeries_) {
+        Snapshot::SeriesRecord record{};
+        record.textOffset = text.size();
+        record.textLength = name.size();
+        text.insert(text.end(), name.begin(), name.end());
+        record.firstDue = toTicks(taskSeries.due.first());
+        record.expandedUntil = toTicks(taskSeries.expandedUntil);
+        record.duration = taskSeries.duration.count();
+        record.priority = static_cast<std::uint8_t>(taskSeries.priority);
+        record.rule = saveRule(taskSeries.due.rule(), exceptions);
+        series.push_back(record);
+    }
+    writer.add(Section::EVENTS, std::move(events));
+    writer.add(Section::SERIES, std::move(series));
+    writer.add(Section::TEXT, std::move(text));
+    writer.add(Section::EXCEPTIONS, std::move(exceptions));
+    
+    // Dependencies and the critical path analysis of the last full pass
+    std::vector<Snapshot::Edge> prerequisites;
+    std::vector<Snapshot::Edge> dependents;
+    for (std::size_t handle = 0; handle < links_.size(); ++handle) {
+        auto task = static_cast<std::uint32_t>(handle);
+        for (auto prerequisite : links_[handle].prerequisites) {
+            prerequisites.push_back(Snapshot::Edge{task, prerequisite});
+        }
+        for (auto dependent : links_[handle].dependents) {
+            dependents.push_back(Snapshot::Edge{task, dependent});
+        }
+    }
+    std::vector<Snapshot::Timing> timings;
+    timings.reserve(timings_->size());
+    for (const auto& timing : *timings_) {
+        timings.push_back(Snapshot::Timing{timing.earliestStart.count(), timing.latestStart.count()});
+    }
+    writer.add(Section::PREREQUISITES, std::move(prerequisites));
+    writer.add(Section::DEPENDENTS, std::move(dependents));
+    writer.add(Section::TIMINGS, std::move(timings));
+    writer.add(Section::CRITICAL_PATH, criticalPath_->data(), criticalPath_->size());
+    
+    return writer.write(path);
+}
+
+std::unique_ptr<TaskScheduler> TaskScheduler::loadSnapshot(const std::string& path) {
+    auto snapshot = Snapshot::open(path);
+    if (!snapshot) {
+        return nullptr;
+    }
+    auto scheduler = std::make_unique<TaskScheduler>();
+    if (!scheduler->restore(*snapshot)) {
+        return nullptr;
+    }
+    return scheduler;
+}
 
 void TaskScheduler::addTask(std::shared_ptr<Task> task) {
-    tasks_.push_back(task);
-    sortTasksByPriority();
+    if (nameIndex_.count(task->getName())) {
+        updateTask(task->getName(), task);
+        return;
+    }
+
+    auto handle = store_->create(task->getName(), task->getDuration(),
+                                 task->getPriority(), task->getDeadline());
+    store_->bind(handle, task);
+    registerTask(handle);
+    if (journal_) {
+        journal_->logAddTask(task->getName(), task->getDuration(), task->getPriority(), task->getDeadline(),
+                             task->isCompleted());
+    }
+}
+
+void TaskScheduler::addTasks(const std::vector<std::shared_ptr<Task>>& tasks) {
+    addTasks(tasks.begin(), tasks.end());
 }
 
 void TaskScheduler::removeTask(const std::string& taskName) {
-    tasks_.erase(
-        std::remove_if(tasks_.begin(), tasks_.end(),
-            [&taskName](const std::shared_ptr<Task>& task) {
-                return task->getName() == taskName;
-            }),
-        tasks_.end()
-    );
+    if (const TaskHandle* handle = nameIndex_.find(taskName)) {
+        if (journal_) {
+            journal_->logRemoveTask(taskName);
+        }
+        eraseTask(*handle);
+    }
 }
 
 void TaskScheduler::updateTask(const std::string& taskName, std::shared_ptr<Task> newTask) {
-    auto it = std::find_if(tasks_.begin(), tasks_.end(),
-        [&taskName](const std::shared_ptr<Task>& task) {
-            return task->getName() == taskName;
-        });
+    const TaskHandle* found = nameIndex_.find(taskName);
+    if (!found) {
+        return;
+    }
+    TaskHandle handle = *found;
+    if (journal_) {
+        journal_->logUpdateTask(taskName, newTask->getName(), newTask->getDuration(), newTask->getPriority(),
+                                newTask->getDeadline(), newTask->isCompleted());
+    }
+
+    releaseTimeSlot(handle);
+    dropDeadline(handle);
+    entries_[handle].dispatched = false;
+    estimates_.erase(handle);
+    nameIndex_.erase(store_->name(handle));
     
-    if (it != tasks_.end()) {
-        *it = newTask;
-        sortTasksByPriority();
+    // A renamed task takes over the new name, replacing any task holding it
+    if (const TaskHandle* clash = nameIndex_.find(newTask->getName())) {
+        eraseTask(*clash);
+    }
+    
+    store_->bind(handle, newTask);
+    nameIndex_.emplace(store_->name(handle), handle);
+    
+    if (store_->priority(handle) != entries_[handle].bucket) {
+        unfileTask(handle);
+        fileTask(handle, store_->priority(handle));
+    } else {
+        markDirty(handle);
+    }
+    if (!store_->isCompleted(handle)) {
+        indexDeadline(handle);
     }
 }
 
-void TaskScheduler::scheduleTasks() {
-    auto now = std::chrono::system_clock::now();
-    
-    for (auto& task : tasks_) {
-        if (!task->isCompleted()) {
-            auto scheduledTime = findNextAvailableTimeSlot(now, task->getDuration());
-            task->setScheduledTime(scheduledTime);
-            now = scheduledTime + task->getDuration();
+void TaskScheduler::completeTask(const std::string& taskName) {
+    if (const TaskHandle* handle = nameIndex_.find(taskName)) {
+        completeTask(*handle);
+    }
+}
+
+std::shared_ptr<Task> TaskScheduler::getTask(const std::string& taskName) const {
+    const TaskHandle* handle = nameIndex_.find(taskName);
+    return handle ? store_->object(*handle) : nullptr;
+}
+
+TaskScheduler::TaskHandle TaskScheduler::addTask(
+    const std::string& name, const std::chrono::minutes& duration,
+    Priority priority, const std::chrono::system_clock::time_point& deadline) {
+    if (const TaskHandle* found = nameIndex_.find(name)) {
+        TaskHandle handle = *found;
+        updateTask(name, std::make_shared<Task>(name, duration, priority, deadline));
+        return handle;
+    }
+    if (journal_) {
+        journal_->logAddTask(name, duration, priority, deadline, false);
+    }
+    return registerTask(store_->create(name, duration, priority, deadline));
+}
+
+void TaskScheduler::removeTask(TaskHandle handle) {
+    if (store_->isValid(handle)) {
+        if (journal_) {
+            journal_->logRemoveTask(store_->name(handle));
         }
+        eraseTask(handle);
     }
 }
 
-void TaskScheduler::rescheduleTasks() {
-    // Clear all scheduled times
-    for (auto& task : tasks_) {
-        task->setScheduledTime(std::chrono::system_clock::time_point::min());
+void TaskScheduler::completeTask(TaskHandle handle) {
+    if (store_->isValid(handle)) {
+        noteCompletion(handle, true);
     }
-    
-    // Reschedule all tasks
-    scheduleTasks();
 }
 
-std::vector<std::shared_ptr<Task>> TaskScheduler::getTasksByPriority(Priority priority) const {
-    std::vector<std::shared_ptr<Task>> result;
-    std::copy_if(tasks_.begin(), tasks_.end(), std::back_inserter(result),
-        [priority](const std::shared_ptr<Task>& task) {
-            return task->getPriority() == priority;
-        });
-    return result;
+TaskScheduler::TaskHandle TaskScheduler::findTask(const std::string& taskName) const {
+    const TaskHandle* handle = nameIndex_.find(taskName);
+    return handle ? *handle : TaskStore::kInvalidHandle;
 }
 
-std::vector<std::shared_ptr<Task>> TaskScheduler::getTasksByDate(
-    const std::chrono::system_clock::time_point& date) const {
-    std::vector<std::shared_ptr<Task>> result;
-    std::copy_if(tasks_.begin(), tasks_.end(), std::back_inserter(result),
-        [&date](const std::shared_ptr<Task>& task) {
-            auto taskDate = std::chrono::system_clock::to_time_t(task->getScheduledTime());
-            auto targetDate = std::chrono::system_clock::to_time_t(date);
-            return std::chrono::system_clock::from_time_t(taskDate) == 
-                   std::chrono::system_clock::from_time_t(targetDate);
-        });
-    return result;
+std::shared_ptr<Task> TaskScheduler::getTask(TaskHandle handle) const {
+    return store_->isValid(handle) ? store_->object(handle) : nullptr;
 }
 
-std::vector<std::shared_ptr<Task>> TaskScheduler::getOverdueTasks() const {
-    auto now = std::chrono::system_clock::now();
-    std::vector<std::shared_ptr<Task>> result;
-    std::copy_if(tasks_.begin(), tasks_.end(), std::back_inserter(result),
-        [&now](const std::shared_ptr<Task>& task) {
-            return !task->isCompleted() && task->getDeadline() < now;
-        });
-    return result;
+std::vector<TaskScheduler::TaskHandle> TaskScheduler::getTaskHandlesByPriority(Priority priority) const {
+    auto b = static_cast<std::size_t>(priority);
+    std::vector<TaskHandle> handles;
+    handles.reserve(buckets_[b].size() - holes_[b]);
+    std::copy_if(buckets_[b].begin(), buckets_[b].end(), std::back_inserter(handles),
+                 [](TaskHandle handle) { return handle != TaskStore::kInvalidHandle; });
+    return handles;
 }
 
-void TaskScheduler::addCalendarEvent(
-    const std::chrono::system_clock::time_point& start,
-    const std::chrono::system_clock::time_point& end,
-    const std::string& description) {
-    calendar_events_[start] = description;
+bool TaskScheduler::changePriority(const std::string& taskName, Priority priority) {
+    const TaskHandle* handle = nameIndex_.find(taskName);
+    return handle && changePriority(*handle, priority);
 }
 
-void TaskScheduler::removeCalendarEvent(const std::string& description) {
-    for (auto it = calendar_events_.begin(); it != calendar_events_.end();) {
-        if (it->second == description) {
-            it = calendar_events_.erase(it);
+bool TaskScheduler::changePriority(TaskHandle handle, Priority priority) {
+    if (!store_->isValid(handle)) {
+        return false;
+    }
+    if (entries_[handle].bucket == priority) {
+        store_->setPriority(handle, priority);
+        return true;
+    }
+    if (journal_) {
+        journal_->logUpdateTask(store_->name(handle), store_->name(handle), store_->duration(handle), priority,
+                                store_->deadline(handle), store_->isCompleted(handle));
+    }
+    store_->setPriority(handle, priority);
+    unfileTask(handle);
+    fileTask(handle, priority);
+    return true;
+}
+
+// Bound Task objects report priority and completion changes back here
+void TaskScheduler::watchStore() {
+    store_->setPriorityHandler([this](TaskHandle handle, Priority priority) { changePriority(handle, priority); });
+    store_->setCompletionHandler([this](TaskHandle handle, bool completed) { noteCompletion(handle, completed); });
+}
+
+void TaskScheduler::noteCompletion(TaskHandle handle, bool completed) {
+    if (store_->isCompleted(handle) == completed) {
+        return;
+    }
+    if (journal_) {
+        if (completed) {
+            journal_->logCompleteTask(store_->name(handle));
+        } else {
+            journal_->logUpdateTask(store_->name(handle), store_->name(handle), store_->duration(handle),
+                                    store_->priority(handle), store_->deadline(handle), false);
+        }
+    }
+    store_->setCompleted(handle, completed);
+    if (completed) {
+        dropDeadline(handle);
+        if (notifier_) {
+            notifier_->cancel(handle, Notification::START);
+        }
+    } else {
+        indexDeadline(handle);
+    }
+
+    // The backlog holds no slots; it is placed when the window reaches it
+    const auto& entry = entries_[handle];
+    Position position{static_cast<std::size_t>(entry.bucket), entry.position};
+    if (!entry.deferred && (!frontier_ || precedes(position, *frontier_))) {
+        markDirty(position);
+    }
+}
+
+void TaskScheduler::scheduleTasks() {
+    // Starting from scratch also starts a fresh window
+    if (horizon_ > std::chrono::minutes(0)) {
+        horizonEnd_ = std::chrono::system_clock::time_point::min();
+    }
+    expandRecurringTasks(std::chrono::system_clock::now());
+    reflowFrom(Position{kPriorityCount - 1, 0});
+}
+
+void TaskScheduler::setLaneCount(std::size_t lanes) {
+    resetLanes(std::max<std::size_t>(lanes, 1));
+    journalSettings();
+}
+
+void TaskScheduler::setTimeGranularity(const std::chrono::minutes& granularity) {
+    granularity_ = std::max(granularity, std::chrono::minutes(0));
+    resetLanes(lanes_->size());
+    journalSettings();
+}
+
+void TaskScheduler::journalSettings() {
+    if (journal_) {
+        journal_->logSettings(lanes_->size(), static_cast<std::uint8_t>(policy_), granularity_, horizon_);
+    }
+}
+
+// Fresh lanes with only their calendar events blocked
+void TaskScheduler::resetLanes(std::size_t lanes) {
+    for (const auto& lane : *lanes_) {
+        for (const auto& placement : lane.placements) {
+            entries_[placement.second].placed = false;
+            if (notifier_) {
+                notifier_->cancel(placement.second, Notification::START);
+            }
+        }
+    }
+    lanes_->assign(lanes, Lane(granularity_));
+    
+    // Events of lanes that are gone are dropped
+    for (auto it = laneEvents_->begin(); it != laneEvents_->end();) {
+        if (it->second >= lanes) {
+            if (journal_) {
+                journal_->logRemoveCalendarEvent(it->first);
+            }
+            calendar_events_->remove(it->first);
+            it = laneEvents_->erase(it);
         } else {
             ++it;
         }
     }
+    for (auto id : calendar_events_->overlapping(std::chrono::system_clock::time_point::min(),
+                                                std::chrono::system_clock::time_point::max())) {
+        const CalendarEvent* event = calendar_events_->find(id);
+        auto laneEvent = laneEvents_->find(id);
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            if (laneEvent == laneEvents_->end() || laneEvent->second == lane) {
+                (*lanes_)[lane].occupy(kEventKeyBit | id, event->start, event->end);
+            }
+        }
+    }
+    for (const auto& [id, recurrence] : calendar_events_->recurring()) {
+        auto laneEvent = laneEvents_->find(id);
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            if (laneEvent == laneEvents_->end() || laneEvent->second == lane) {
+                (*lanes_)[lane].recurring.emplace(id, recurrence);
+            }
+        }
+    }
+    markDirty(Position{kPriorityCount - 1, 0});
 }
 
-bool TaskScheduler::isTimeSlotAvailable(
-    const std::chrono::system_clock::time_point& start,
-    const std::chrono::minutes& duration) const {
+std::optional<std::size_t> TaskScheduler::getTaskLane(TaskHandle handle) const {
+    if (!store_->isValid(handle) || !entries_[handle].placed) {
+        return std::nullopt;
+    }
+    return entries_[handle].lane;
+}
+
+void TaskScheduler::setSchedulingPolicy(SchedulingPolicy policy) {
+    if (policy != policy_) {
+        policy_ = policy;
+        markDirty(Position{kPriorityCount - 1, 0});
+        journalSettings();
+    }
+}
+
+void TaskScheduler::setSchedulingHorizon(const std::chrono::minutes& horizon) {
+    horizon_ = std::max(horizon, std::chrono::minutes(0));
+    horizonEnd_ = horizon_ > std::chrono::minutes(0) ? std::chrono::system_clock::time_point::min()
+                                                     : std::chrono::system_clock::time_point::max();
+    markDirty(Position{kPriorityCount - 1, 0});
+    journalSettings();
+}
+
+void TaskScheduler::extendHorizon(const std::chrono::system_clock::time_point& until) {
+    if (until <= horizonEnd_) {
+        return;
+    }
+    horizonEnd_ = until;
+    if (frontier_) {
+        markDirty(*frontier_);
+    }
+    rescheduleTasks();
+}
+
+TaskScheduler::FeasibilityReport TaskScheduler::getFeasibilityReport() const {
+    FeasibilityReport report;
+    for (const auto& [handle, lateness] : lateTasks()) {
+        if (lateness != std::chrono::minutes::max()) {
+            report.weightedLateness += lateness * priorityWeight(store_->priority(handle));
+        }
+        report.feasible = false;
+        report.maxLateness = std::max(report.maxLateness, lateness);
+        report.lateTasks.push_back(LateTask{store_->object(handle), lateness});
+    }
+    return report;
+}
+
+std::vector<std::pair<TaskScheduler::TaskHandle, std::chrono::minutes>> TaskScheduler::lateTasks() const {
+    // deadlines_ holds exactly the pending tasks, already in deadline order
+    std::vector<std::pair<TaskHandle, std::chrono::minutes>> late;
+    for (const auto& [deadline, handle] : deadlines_) {
+        if (store_->isCompleted(handle)) {
+            continue;
+        }
+        
+        // Unplaced tasks (on a dependency cycle, or fitting no gap) never
+        // finish. Backlog tasks start at the horizon at the earliest, so that
+        // bounds their lateness; the sum saturates, as the horizon may be
+        // unbounded.
+        auto lateness = std::chrono::minutes::max();
+        bool placed = entries_[handle].placed;
+        if (placed || isBacklogged(handle)) {
+            auto start = placed ? store_->scheduledTime(handle) : horizonEnd_;
+            auto duration = store_->duration(handle);
+            auto finish = start > std::chrono::system_clock::time_point::max() - duration
+                ? std::chrono::system_clock::time_point::max()
+                : start + duration;
+            if (finish <= deadline) {
+                continue;
+            }
+            if (finish != std::chrono::system_clock::time_point::max()) {
+                lateness = std::chrono::ceil<std::chrono::minutes>(finish - deadline);
+            }
+        }
+        late.emplace_back(handle, lateness);
+    }
+    return late;
+}
+
+bool TaskScheduler::admitTask(std::shared_ptr<Task> task) {
+    if (nameIndex_.count(task->getName())) {
+        return false;
+    }
+    
+    rescheduleTasks();
+    std::unordered_map<TaskHandle, std::chrono::minutes> before;
+    for (const auto& [handle, lateness] : lateTasks()) {
+        before.emplace(handle, lateness);
+    }
     
-    auto end = start + duration;
+    // Dry run on a fork, which shares the handles of every existing task
+    // and has no journal or notifier to tell about it
+    auto trial = fork();
+    auto added = trial->addTask(task->getName(), task->getDuration(), task->getPriority(), task->getDeadline());
+    if (task->isCompleted()) {
+        trial->completeTask(added);
+    }
+    trial->rescheduleTasks();
     
-    // Check calendar events
-    for (const auto& event : calendar_events_) {
-        if (start < event.first && end > event.first) {
+    // Every task late now, the new one included, must have been late before
+    // and by no less
+    for (const auto& [handle, lateness] : trial->lateTasks()) {
+        auto it = before.find(handle);
+        if (it == before.end() || lateness > it->second) {
             return false;
         }
     }
+    addTask(task);
+    rescheduleTasks();
+    return true;
+}
+
+TaskScheduler::OptimizerResult TaskScheduler::optimizeSchedule(Executor& executor) {
+    return optimizeSchedule(executor, OptimizerOptions{});
+}
+
+TaskScheduler::OptimizerResult TaskScheduler::optimizeSchedule(Executor& executor,
+                                                               const OptimizerOptions& options) {
+    rescheduleTasks();
     
-    // Check scheduled tasks
-    for (const auto& task : tasks_) {
-        if (task->getScheduledTime() != std::chrono::system_clock::time_point::min()) {
-            auto taskEnd = task->getScheduledTime() + task->getDuration();
-            if (start < taskEnd && end > task->getScheduledTime()) {
-                return false;
+    OptimizerResult result;
+    std::vector<std::int64_t> before(lanes_->size());
+    for (std::size_t lane = 0; lane < lanes_->size(); ++lane) {
+        before[lane] = laneTardiness(lane);
+        result.weightedTardinessBefore += std::chrono::minutes(before[lane]);
+    }
+    result.weightedTardinessAfter = result.weightedTardinessBefore;
+    if (dependencyCount_ > 0 || result.weightedTardinessBefore.count() == 0) {
+        return result;
+    }
+    
+    // One sequence problem per lane, in minutes from the lane's first start
+    struct LaneProblem {
+        std::vector<TaskHandle> handles;
+        std::vector<std::chrono::system_clock::time_point> starts;
+        std::unique_ptr<SequenceOptimizer> optimizer;
+        std::vector<SequenceOptimizer::Result> runs;
+    };
+    std::size_t restarts = options.restarts ? options.restarts : executor.getThreadCount();
+    std::vector<LaneProblem> problems(lanes_->size());
+    std::size_t jobs = 0;
+    for (std::size_t lane = 0; lane < lanes_->size(); ++lane) {
+        auto& problem = problems[lane];
+        if (before[lane] == 0 || (*lanes_)[lane].placements.size() < 2) {
+            continue;
+        }
+        
+        auto base = (*lanes_)[lane].placements.begin()->first;
+        std::vector<SequenceOptimizer::Job> sequence;
+        for (const auto& [start, handle] : (*lanes_)[lane].placements) {
+            auto due = std::chrono::duration_cast<std::chrono::minutes>(store_->deadline(handle) - base);
+            sequence.push_back(SequenceOptimizer::Job{store_->duration(handle).count(), due.count(),
+                                                      priorityWeight(store_->priority(handle))});
+            problem.handles.push_back(handle);
+            problem.starts.push_back(start);
+        }
+        problem.optimizer = std::make_unique<SequenceOptimizer>(std::move(sequence));
+        problem.runs.resize(restarts);
+        jobs += restarts;
+    }
+    if (jobs == 0) {
+        return result;
+    }
+    
+    // Runs execute a thread count at a time, so split the budget accordingly
+    auto waves = (jobs + executor.getThreadCount() - 1) / executor.getThreadCount();
+    auto budget = std::chrono::duration_cast<std::chrono::nanoseconds>(options.timeBudget) / waves;
+    Executor::Batch batch(executor);
+    for (std::size_t lane = 0; lane < problems.size(); ++lane) {
+        auto& problem = problems[lane];
+        for (std::size_t run = 0; run < problem.runs.size(); ++run) {
+            // The first run starts from the greedy order, the others from EDD
+            std::uint64_t seed = options.seed + lane * restarts + run;
+            batch.submit([&problem, run, budget, seed] {
+                std::vector<std::uint32_t> order;
+                if (run == 0) {
+                    order.resize(problem.handles.size());
+                    for (std::uint32_t i = 0; i < order.size(); ++i) {
+                        order[i] = i;
+                    }
+                } else {
+                    order = problem.optimizer->dueOrder();
+                }
+                problem.runs[run] = problem.optimizer->anneal(std::move(order), budget, seed);
+            });
+        }
+    }
+    batch.wait();
+    
+    // Place the best order of each lane through the calendar, keep it if the
+    // real tardiness went down
+    for (std::size_t lane = 0; lane < problems.size(); ++lane) {
+        auto& problem = problems[lane];
+        if (problem.runs.empty()) {
+            continue;
+        }
+        auto best = std::min_element(problem.runs.begin(), problem.runs.end(),
+                                     [](const auto& a, const auto& b) { return a.cost < b.cost; });
+        for (const auto& run : problem.runs) {
+            result.moves += run.moves;
+        }
+        
+        for (auto handle : problem.handles) {
+            releaseTimeSlot(handle);
+        }
+        auto cursor = problem.starts.front();
+        bool fits = true;
+        for (auto index : best->order) {
+            auto handle = problem.handles[index];
+            auto duration = store_->duration(handle);
+            auto scheduledTime = findNextAvailableTimeSlot(lane, cursor, duration);
+            if (scheduledTime == std::chrono::system_clock::time_point::max()) {
+                fits = false;
+                break;
+            }
+            placeTask(handle, lane, scheduledTime);
+            cursor = scheduledTime + duration;
+        }
+        
+        auto after = fits ? laneTardiness(lane) : before[lane];
+        if (after < before[lane]) {
+            result.weightedTardinessAfter -= std::chrono::minutes(before[lane] - after);
+            result.improved = true;
+            continue;
+        }
+        for (auto handle : problem.handles) {
+            releaseTimeSlot(handle);
+        }
+        for (std::size_t i = 0; i < problem.handles.size(); ++i) {
+            placeTask(problem.handles[i], lane, problem.starts[i]);
+        }
+    }
+    return result;
+}
+
+bool TaskScheduler::setDurationEstimate(const std::string& taskName, const DurationEstimate& estimate) {
+    return setDurationEstimate(findTask(taskName), estimate);
+}
+
+bool TaskScheduler::setDurationEstimate(TaskHandle handle, const DurationEstimate& estimate) {
+    if (!store_->isValid(handle) || estimate.optimistic < std::chrono::minutes(0) ||
+        estimate.optimistic > estimate.likely || estimate.likely > estimate.pessimistic) {
+        return false;
+    }
+    estimates_.insertOrAssign(handle, estimate);
+    return true;
+}
+
+TaskScheduler::RiskReport TaskScheduler::simulateRisk(Executor& executor) {
+    return simulateRisk(executor, RiskOptions{});
+}
+
+TaskScheduler::RiskReport TaskScheduler::simulateRisk(Executor& executor, const RiskOptions& options) {
+    rescheduleTasks();
+    
+    // Placed pending tasks by planned start, each lane's in lane order
+    std::vector<std::pair<std::chrono::system_clock::time_point, TaskHandle>> planned;
+    for (const auto& lane : *lanes_) {
+        for (const auto& [start, handle] : lane.placements) {
+            if (!store_->isCompleted(handle)) {
+                planned.emplace_back(start, handle);
+            }
+        }
+    }
+    std::stable_sort(planned.begin(), planned.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    RiskReport report;
+    report.iterations = options.iterations;
+    if (planned.empty()) {
+        return report;
+    }
+    
+    // Waiting edges: the lane predecessor and pending prerequisites. Every
+    // one of them is planned to finish before the task starts, so planned
+    // start order is a topological order, except for zero length tasks
+    // starting at the same time; a stable Kahn pass settles those.
+    std::unordered_map<TaskHandle, std::uint32_t> index;
+    index.reserve(planned.size());
+    for (std::uint32_t i = 0; i < planned.size(); ++i) {
+        index.emplace(planned[i].second, i);
+    }
+    std::vector<std::vector<std::uint32_t>> waitsFor(planned.size());
+    std::vector<TaskHandle> previous(lanes_->size(), TaskStore::kInvalidHandle);
+    for (std::uint32_t i = 0; i < planned.size(); ++i) {
+        auto handle = planned[i].second;
+        auto& lastOnLane = previous[entries_[handle].lane];
+        if (lastOnLane != TaskStore::kInvalidHandle) {
+            waitsFor[i].push_back(index[lastOnLane]);
+        }
+        lastOnLane = handle;
+        if (handle < links_.size()) {
+            for (auto prerequisite : links_[handle].prerequisites) {
+                auto found = index.find(prerequisite);
+                if (found != index.end()) {
+                    waitsFor[i].push_back(found->second);
+                }
+            }
+        }
+    }
+    std::vector<std::uint32_t> order;
+    order.reserve(planned.size());
+    {
+        std::vector<std::uint32_t> blocking(planned.size(), 0);
+        std::vector<std::vector<std::uint32_t>> released(planned.size());
+        for (std::uint32_t i = 0; i < planned.size(); ++i) {
+            blocking[i] = static_cast<std::uint32_t>(waitsFor[i].size());
+            for (auto p : waitsFor[i]) {
+                released[p].push_back(i);
+            }
+        }
+        std::priority_queue<std::uint32_t, std::vector<std::uint32_t>, std::greater<std::uint32_t>> ready;
+        for (std::uint32_t i = 0; i < planned.size(); ++i) {
+            if (blocking[i] == 0) {
+                ready.push(i);
+            }
+        }
+        while (!ready.empty()) {
+            auto i = ready.top();
+            ready.pop();
+            order.push_back(i);
+            for (auto next : released[i]) {
+                if (--blocking[next] == 0) {
+                    ready.push(next);
+                }
             }
         }
     }
+    std::vector<std::uint32_t> rank(planned.size());
+    for (std::uint32_t r = 0; r < order.size(); ++r) {
+        rank[order[r]] = r;
+    }
+    
+    // Jobs in minutes from the first planned start
+    auto base = planned.front().first;
+    auto minutesFrom = [base](const std::chrono::system_clock::time_point& time) {
+        return std::chrono::duration<double, std::ratio<60>>(time - base).count();
+    };
+    std::vector<RiskSimulator::Job> jobs;
+    std::vector<std::vector<std::uint32_t>> predecessors(order.size());
+    jobs.reserve(order.size());
+    for (std::uint32_t r = 0; r < order.size(); ++r) {
+        auto handle = planned[order[r]].second;
+        double fixed = static_cast<double>(store_->duration(handle).count());
+        RiskSimulator::Job job{minutesFrom(planned[order[r]].first), minutesFrom(store_->deadline(handle)),
+                               fixed, fixed, fixed};
+        if (const DurationEstimate* estimate = estimates_.find(handle)) {
+            job.low = static_cast<double>(estimate->optimistic.count());
+            job.mode = static_cast<double>(estimate->likely.count());
+            job.high = static_cast<double>(estimate->pessimistic.count());
+        }
+        jobs.push_back(job);
+        for (auto p : waitsFor[order[r]]) {
+            predecessors[r].push_back(rank[p]);
+        }
+    }
+    RiskSimulator simulator(jobs, predecessors);
+    
+    // One chunk of passes per executor thread, each with its own buffers
+    std::uint64_t passes = options.iterations;
+    std::uint64_t sampleCount = std::min<std::uint64_t>(options.samples, passes);
+    std::vector<float> samples(sampleCount * simulator.size());
+    std::size_t chunks = std::max<std::size_t>(1, std::min<std::uint64_t>(executor.getThreadCount(), passes));
+    std::vector<RiskSimulator::Tally> tallies(chunks);
+    Executor::Batch batch(executor);
+    for (std::size_t c = 0; c < chunks; ++c) {
+        std::uint64_t first = passes * c / chunks;
+        std::uint64_t last = passes * (c + 1) / chunks;
+        batch.submit([&simulator, &tallies, &samples, c, first, last, sampleCount, seed = options.seed] {
+            tallies[c] = simulator.makeTally();
+            simulator.run(first, last, seed, tallies[c], samples.data(), sampleCount);
+        });
+    }
+    batch.wait();
+    auto result = simulator.summarize(tallies, passes, samples, sampleCount);
+    
+    auto timeAt = [base](double minutes) {
+        return base + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                          std::chrono::duration<double, std::ratio<60>>(minutes));
+    };
+    report.tasks.reserve(order.size());
+    for (std::uint32_t r = 0; r < order.size(); ++r) {
+        const auto& stats = result.jobs[r];
+        report.tasks.push_back(TaskRisk{store_->object(planned[order[r]].second), stats.missProbability});
+        if (sampleCount > 0) {
+            report.tasks.back().p50Finish = timeAt(stats.p50Finish);
+            report.tasks.back().p90Finish = timeAt(stats.p90Finish);
+        }
+    }
+    if (sampleCount > 0) {
+        report.p50Finish = timeAt(result.p50Finish);
+        report.p90Finish = timeAt(result.p90Finish);
+    }
+    return report;
+}
+
+// Weighted tardiness of a lane's placed tasks, in minutes
+std::int64_t TaskScheduler::laneTardiness(std::size_t lane) const {
+    std::int64_t total = 0;
+    for (const auto& [start, handle] : (*lanes_)[lane].placements) {
+        auto finish = start + store_->duration(handle);
+        if (finish > store_->deadline(handle)) {
+            auto lateness = std::chrono::ceil<std::chrono::minutes>(finish - store_->deadline(handle));
+            total += lateness.count() * priorityWeight(store_->priority(handle));
+        }
+    }
+    return total;
+}
+
+bool TaskScheduler::addDependency(const std::string& taskName, const std::string& prerequisiteName) {
+    return addDependency(findTask(taskName), findTask(prerequisiteName));
+}
+
+bool TaskScheduler::removeDependency(const std::string& taskName, const std::string& prerequisiteName) {
+    return removeDependency(findTask(taskName), findTask(prerequisiteName));
+}
+
+bool TaskScheduler::addDependency(TaskHandle task, TaskHandle prerequisite) {
+    if (!store_->isValid(task) || !store_->isValid(prerequisite) || task == prerequisite) {
+        return false;
+    }
+    if (links_.size() < store_->capacity()) {
+        links_.resize(store_->capacity());
+    }
     
+    auto& prerequisites = links_[task].prerequisites;
+    if (std::find(prerequisites.begin(), prerequisites.end(), prerequisite) != prerequisites.end()) {
+        return false;
+    }
+    if (journal_) {
+        journal_->logAddDependency(store_->name(task), store_->name(prerequisite));
+    }
+    prerequisites.push_back(prerequisite);
+    links_[prerequisite].dependents.push_back(task);
+    ++dependencyCount_;
+    markDirty(task);
     return true;
 }
 
-std::chrono::system_clock::time_point TaskScheduler::findNextAvailableTimeSlot(
-    const std::chrono::system_clock::time_point& start,
-    const std::chrono::minutes& duration) const {
+bool TaskScheduler::removeDependency(TaskHandle task, TaskHandle prerequisite) {
+    if (!store_->isValid(task) || !store_->isValid(prerequisite) || task >= links_.size() ||
+        prerequisite >= links_.size()) {
+        return false;
+    }
     
-    auto current = start;
-    while (!isTimeSlotAvailable(current, duration)) {
-        current += std::chrono::minutes(30); // Check every 30 minutes
+    auto& prerequisites = links_[task].prerequisites;
+    auto it = std::find(prerequisites.begin(), prerequisites.end(), prerequisite);
+    if (it == prerequisites.end()) {
+        return false;
+    }
+    if (journal_) {
+        journal_->logRemoveDependency(store_->name(task), store_->name(prerequisite));
     }
-    return current;
+    prerequisites.erase(it);
+    auto& dependents = links_[prerequisite].dependents;
+    dependents.erase(std::find(dependents.begin(), dependents.end(), task));
+    --dependencyCount_;
+    markDirty(task);
+    if (dependencyCount_ == 0) {
+        // Incremental passes expect placements in scheduling order again
+        markDirty(Position{kPriorityCount - 1, 0});
+    }
+    return true;
 }
 
-void TaskScheduler::sortTasksByPriority() {
-    std::sort(tasks_.begin(), tasks_.end(),
-        [](const std::shared_ptr<Task>& a, const std::shared_ptr<Task>& b) {
-            return static_cast<int>(a->getPriority()) > static_cast<int>(b->getPriority());
-        });
-} 
\ No newline at end of file
+std::optional<TaskScheduler::TaskTiming> TaskScheduler::getTaskTiming(TaskHandle handle) const {
+    if (handle >= timings_->size() || !store_->isValid(handle) || !entries_[handle].placed) {
+        return std::nullopt;
+    }
+    return (*timings_)[handle];
+}
+
+std::vector<std::shared_ptr<Task>> TaskScheduler::getCriticalPath() const {
+    std::vector<std::shared_ptr<Task>> result;
+    for (auto handle : *criticalPath_) {
+        result.push_back(store_->object(handle));
+    }
+    return result;
+}
+
+void TaskScheduler::rescheduleTasks() {
+    expandRecurringTasks(std::chrono::system_clock::now());
+    
+    // Once the window has moved on by a minute, place what it now covers
+    if (frontier_ && horizon_ > std::chrono::minutes(0) &&
+        std::chrono::system_clock::now() + horizon_ - std::chrono::minutes(1) >= horizonEnd_) {
+        markDirty(*frontier_);
+    }
+    
+    if (dirty_) {
+        reflowFrom(*dirty_);
+    }
+}
+
+TaskView TaskScheduler::getTasksByPriority(Priority priority) const {
+    auto b = static_cast<std::size_t>(priority);
+    return TaskView(*store_, buckets_[b], buckets_[b].size() - holes_[b]);
+}
+
+std::vector<std::shared_ptr<Task>> TaskScheduler::getTasksByDate(
+    const std::chrono::system_clock::time_point& date) const {
+    return getTasksByDateRange(date, 1);
+}
+
+std::vector<std::shared_ptr<Task>> TaskScheduler::getTasksByDateRange(
+    const std::chrono::system_clock::time_point& firstDate, int days) const {
+    auto from = startOfDay(firstDate);
+    auto to = addDays(from, days);
+    std::vector<std::shared_ptr<Task>> result;
+    for (auto handle : placedBetween(from, to)) {
+        result.push_back(store_->object(handle));
+    }
+    return result;
+}
+
+std::vector<std::shared_ptr<Task>> TaskScheduler::getTasksByWeek(
+    const std::chrono::system_clock::time_point& firstDate) const {
+    return getTasksByDateRange(firstDate, 7);
+}
+
+std::vector<std::shared_ptr<Task>> TaskScheduler::getOverdueTasks() const {
+    auto now = std::chrono::system_clock::now();
+    std::vector<std::shared_ptr<Task>> result;
+    for (auto it = deadlines_.begin(); it != deadlines_.end() && it->first < now; ++it) {
+        if (!store_->isCompleted(it->second)) {
+            result.push_back(store_->object(it->second));
+        }
+    }
+    return result;
+}
+
+std::shared_ptr<Task> TaskScheduler::getNextDeadlineTask() const {
+    return getNextDeadlineTask(std::chrono::system_clock::now());
+}
+
+std::shared_ptr<Task> TaskScheduler::getNextDeadlineTask(
+    const std::chrono::system_clock::time_point& after) const {
+    for (auto it = deadlines_.lower_bound({after, 0}); it != deadlines_.end(); ++it) {
+        if (!store_->isCompleted(it->second)) {
+            return store_->object(it->second);
+        }
+    }
+    return nullptr;
+}
+
+EventStore::Id TaskScheduler::addCalendarEvent(
+    const std::chrono::system_clock::time_point& start,
+    const std::chrono::system_clock::time_point& end,
+    const std::string& description) {
+    auto id = calendar_events_->add(start, end, description);
+    if (journal_) {
+        journal_->logAddCalendarEvent(id, start, end, description, std::nullopt);
+    }
+    for (std::size_t lane = 0; lane < lanes_->size(); ++lane) {
+        blockLane(lane, id, start, end);
+    }
+    return id;
+}
+
+EventStore::Id TaskScheduler::addCalendarEvent(
+    const std::chrono::system_clock::time_point& start,
+    const std::chrono::system_clock::time_point& end,
+    const std::string& description, std::size_t lane) {
+    if (lane >= lanes_->size()) {
+        return EventStore::kInvalidId;
+    }
+    auto id = calendar_events_->add(start, end, description);
+    if (journal_) {
+        journal_->logAddCalendarEvent(id, start, end, description, lane);
+    }
+    laneEvents_->emplace(id, lane);
+    blockLane(lane, id, start, end);
+    return id;
+}
+
+EventStore::Id TaskScheduler::addRecurringEvent(
+    const std::chrono::system_clock::time_point& start,
+    const std::chrono::system_clock::time_point& end,
+    const std::string& description, const RecurrenceRule& rule) {
+    auto id = calendar_events_->add(start, end, description, rule);
+    if (journal_) {
+        journal_->logAddRecurringEvent(id, start, end, description, rule, std::nullopt);
+    }
+    auto recurrence = calendar_events_->findRecurrence(id);
+    for (std::size_t lane = 0; lane < lanes_->size(); ++lane) {
+        blockLane(lane, id, recurrence);
+    }
+    return id;
+}
+
+EventStore::Id TaskScheduler::addRecurringEvent(
+    const std::chrono::system_clock::time_point& start,
+    const std::chrono::system_clock::time_point& end,
+    const std::string& description, const RecurrenceRule& rule, std::size_t lane) {
+    if (lane >= lanes_->size()) {
+        return EventStore::kInvalidId;
+    }
+    
+    auto id = calendar_events_->add(start, end, description, rule);
+    if (journal_) {
+        journal_->logAddRecurringEvent(id, start, end, description, rule, lane);
+    }
+    laneEvents_->emplace(id, lane);
+    blockLane(lane, id, calendar_events_->findRecurrence(id));
+    return id;
+}
+
+bool TaskScheduler::addRecurringTask(const std::string& name, const std::chrono::minutes& duration,
+                                     Priority priority, const std::chrono::system_clock::time_point& firstDue,
+                                     const RecurrenceRule& rule) {
+    if (taskSeries_->count(name)) {
+        return false;
+    }
+    if (journal_) {
+        journal_->logAddRecurringTask(name, duration, priority, firstDue, rule);
+    }
+    taskSeries_->emplace(name, TaskSeries{Recurrence(firstDue, std::chrono::minutes(0), rule),
+                                          duration, priority, firstDue});
+    return true;
+}
+
+bool TaskScheduler::removeRecurringTask(const std::string& name) {
+    if (!taskSeries_->erase(name)) {
+        return false;
+    }
+    if (journal_) {
+        journal_->logRemoveRecurringTask(name);
+    }
+    return true;
+}
+
+void TaskScheduler::skipRecurringTask(const std::string& name, const std::chrono::system_clock::time_point& until) {
+    auto it = taskSeries_->find(name);
+    if (it != taskSeries_->end()) {
+        it->second.expandedUntil = std::max(it->second.expandedUntil, until);
+    }
+}
+
+void TaskScheduler::removeCalendarEvent(const std::string& description) {
+    std::vector<EventStore::Id> ids = calendar_events_->findByDescription(description);
+    for (auto id : ids) {
+        removeCalendarEvent(id);
+    }
+}
+
+bool TaskScheduler::removeCalendarEvent(EventStore::Id id) {
+    const CalendarEvent* event = calendar_events_->find(id);
+    if (!event) {
+        return false;
+    }
+    if (journal_) {
+        journal_->logRemoveCalendarEvent(id);
+    }
+    
+    auto laneEvent = laneEvents_->find(id);
+    if (laneEvent != laneEvents_->end()) {
+        unblockLane(laneEvent->second, id, event->start);
+        laneEvents_->erase(laneEvent);
+    } else {
+        for (std::size_t lane = 0; lane < lanes_->size(); ++lane) {
+            unblockLane(lane, id, event->start);
+        }
+    }
+    calendar_events_->remove(id);
+    return true;
+}
+
+std::size_t TaskScheduler::dispatchTasks(Executor& executor,
+                                         const std::chrono::system_clock::time_point& until) {
+    std::size_t dispatched = 0;
+    for (auto handle : placedBetween(std::chrono::system_clock::time_point::min(), until)) {
+        auto& entry = entries_[handle];
+        if (entry.dispatched || store_->isCompleted(handle) || !store_->payload(handle)) {
+            continue;
+        }
+        
+        entry.dispatched = true;
+        entry.ticket = ++nextTicket_;
+        executor.submit([this, handle, ticket = entry.ticket, payload = store_->payload(handle)] {
+            bool succeeded = true;
+            try {
+                payload();
+            } catch (...) {
+                succeeded = false;
+            }
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            completions_.push_back(Completion{handle, ticket, succeeded});
+        }, store_->priority(handle));
+        ++dispatched;
+    }
+    return dispatched;
+}
+
+std::size_t TaskScheduler::processCompletions() {
+    std::vector<Completion> completions;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        completions.swap(completions_);
+    }
+    
+    // Reports for tasks removed or replaced meanwhile are stale
+    std::vector<TaskHandle> completed;
+    for (const auto& completion : completions) {
+        auto handle = completion.handle;
+        if (!store_->isValid(handle) || !entries_[handle].dispatched ||
+            entries_[handle].ticket != completion.ticket) {
+            continue;
+        }
+        entries_[handle].dispatched = false;
+        if (completion.succeeded) {
+            completeTask(handle);
+            completed.push_back(handle);
+        }
+    }
+    
+    if (!completed.empty()) {
+        rescheduleTasks();
+    }
+    if (completionCallback_) {
+        for (auto handle : completed) {
+            if (store_->isValid(handle)) {
+                completionCallback_(store_->object(handle));
+            }
+        }
+    }
+    return completed.size();
+}
+
+void TaskScheduler::startNotifications(std::function<void(TaskHandle, Notification)> callback,
+                                       std::chrono::milliseconds resolution) {
+    notifier_.reset();
+    notifier_ = std::make_unique<TaskNotifier>(std::move(callback), resolution);
+    for (const auto& bucket : buckets_) {
+        for (auto handle : bucket) {
+            if (handle == TaskStore::kInvalidHandle) {
+                continue;
+            }
+            const auto& entry = entries_[handle];
+            if (entry.placed) {
+                notifier_->arm(handle, Notification::START, entry.placedAt);
+            }
+            if (entry.deadlineIndexed) {
+                notifier_->arm(handle, Notification::DEADLINE, store_->deadline(handle));
+            }
+        }
+    }
+}
+
+std::vector<CalendarEvent> TaskScheduler::getCalendarEvents(
+    const std::chrono::system_clock::time_point& from,
+    const std::chrono::system_clock::time_point& to) const {
+    std::vector<CalendarEvent> result;
+    for (auto id : calendar_events_->overlapping(from, to)) {
+        result.push_back(*calendar_events_->find(id));
+    }
+    if (!calendar_events_->recurring().empty()) {
+        calendar_events_->occurrences(from, to, result);
+        std::stable_sort(result.begin(), result.end(),
+                         [](const CalendarEvent& a, const CalendarEvent& b) { return a.start < b.start; });
+    }
+    return result;
+}
+
+bool TaskScheduler::isTimeSlotAvailable(
+    std::size_t lane, const std::chrono::system_clock::time_point& start,
+    const std::chrono::minutes& duration) const {
+    return (*lanes_)[lane].isFree(start, start + duration);
+}
+
+std::chrono::system_clock::time_point TaskScheduler::findNextAvailableTimeSlot(
+    std::size_t lane, const std::chrono::system_clock::time_point& start,
+    const std::chrono::minutes& duration) const {
+    return (*lanes_)[lane].findFirstFit(start, duration);
+}
+
+std::chrono::system_clock::time_point TaskScheduler::startOfDay(
+    const std::chrono::system_clock::time_point& time) const {
+    if (utcOffset_) {
+        return std::chrono::floor<Days>(time + *utcOffset_) - *utcOffset_;
+    }
+
+    std::tm local = toLocalTime(std::chrono::system_clock::to_time_t(time));
+    local.tm_hour = 0;
+    local.tm_min = 0;
+    local.tm_sec = 0;
+    local.tm_isdst = -1;
+    return std::chrono::system_clock::from_time_t(std::mktime(&local));
+}
+
+std::chrono::system_clock::time_point TaskScheduler::addDays(
+    const std::chrono::system_clock::time_point& dayStart, int days) const {
+    if (utcOffset_) {
+        return dayStart + Days(days);
+    }
+
+    // Let mktime normalise the day so 23 and 25 hour DST days come out right
+    std::tm local = toLocalTime(std::chrono::system_clock::to_time_t(dayStart));
+    local.tm_mday += days;
+    local.tm_isdst = -1;
+    return std::chrono::system_clock::from_time_t(std::mktime(&local));
+}
+
+// Rebuilds a fresh scheduler from a snapshot. Task columns are copied
+// wholesale; the indexes over them (names, deadlines, lanes) are rebuilt
+// from the saved order without any scheduling. Anything inconsistent in
+// the file makes it fail rather than leave a broken scheduler behind.
+bool TaskScheduler::restore(const Snapshot& snapshot) {
+    using Section = Snapshot::Section;
+    const auto& header = snapshot.header();
+    if (header.laneCount == 0 || header.policy > static_cast<std::uint32_t>(SchedulingPolicy::WEIGHTED_LATENESS) ||
+        header.granularity < 0 || header.horizon < 0 || !store_->restore(snapshot) ||
+        header.taskCapacity != store_->capacity()) {
+        return false;
+    }
+    std::size_t capacity = store_->capacity();
+    policy_ = static_cast<SchedulingPolicy>(header.policy);
+    granularity_ = std::chrono::minutes(header.granularity);
+    horizon_ = std::chrono::minutes(header.horizon);
+    horizonEnd_ = fromTicks(header.horizonEnd);
+    if (header.hasUtcOffset) {
+        utcOffset_ = std::chrono::minutes(header.utcOffset);
+    }
+    
+    // Calendar events keep their ids, then every lane gets its events back
+    auto text = snapshot.column<char>(Section::TEXT);
+    auto exceptions = snapshot.column<std::int64_t>(Section::EXCEPTIONS);
+    for (const auto& record : snapshot.column<Snapshot::EventRecord>(Section::EVENTS)) {
+        auto description = loadText(text, record.textOffset, record.textLength);
+        if (!description || (record.id & kEventKeyBit)) {
+            return false;
+        }
+        bool inserted;
+        if (record.recurring) {
+            auto rule = loadRule(record.rule, exceptions);
+            inserted = rule && calendar_events_->insert(record.id, fromTicks(record.start), fromTicks(record.end),
+                                                        *description, *rule);
+        } else {
+            inserted = calendar_events_->insert(record.id, fromTicks(record.start), fromTicks(record.end),
+                                                *description);
+        }
+        if (!inserted) {
+            return false;
+        }
+        if (record.lane != Snapshot::kNoLane) {
+            if (record.lane >= header.laneCount) {
+                return false;
+            }
+            laneEvents_->emplace(record.id, record.lane);
+        }
+    }
+    calendar_events_->skipIds(header.nextEventId);
+    resetLanes(header.laneCount);
+    
+    // Buckets come back in their saved order, so positions do too
+    auto order = snapshot.column<std::uint32_t>(Section::BUCKETS);
+    auto placements = snapshot.column<Snapshot::Placement>(Section::PLACEMENTS);
+    if (placements.size() != capacity) {
+        return false;
+    }
+    entries_.assign(capacity, Entry{});
+    std::vector<std::uint8_t> filed(capacity, 0);
+    std::size_t next = 0;
+    holes_ = {};
+    for (std::size_t b = 0; b < kPriorityCount; ++b) {
+        if (header.bucketSizes[b] > order.size() - next) {
+            return false;
+        }
+        auto& bucket = buckets_[b];
+        bucket.assign(order.begin() + next, order.begin() + next + header.bucketSizes[b]);
+        next += bucket.size();
+        for (std::size_t i = 0; i < bucket.size(); ++i) {
+            auto handle = bucket[i];
+            if (!store_->isValid(handle) || filed[handle]) {
+                return false;
+            }
+            filed[handle] = 1;
+            const auto& placement = placements[handle];
+            auto& entry = entries_[handle];
+            entry.bucket = static_cast<Priority>(b);
+            entry.position = i;
+            entry.placed = placement.flags & Snapshot::PLACED;
+            entry.deferred = placement.flags & Snapshot::DEFERRED;
+            entry.deadlineIndexed = placement.flags & Snapshot::DEADLINE_INDEXED;
+            entry.lane = placement.lane;
+            entry.placedAt = fromTicks(placement.placedAt);
+            if (entry.placed && entry.lane >= header.laneCount) {
+                return false;
+            }
+        }
+    }
+    if (next != order.size()) {
+        return false;
+    }
+    
+    // Indexes over the live tasks
+    std::vector<std::vector<std::pair<std::chrono::system_clock::time_point, TaskHandle>>> laneTasks(
+        header.laneCount);
+    std::vector<std::pair<std::chrono::system_clock::time_point, TaskHandle>> due;
+    nameIndex_.reserve(order.size());
+    for (TaskHandle handle = 0; handle < capacity; ++handle) {
+        if (!store_->isValid(handle)) {
+            continue;
+        }
+        if (!filed[handle] || !nameIndex_.emplace(store_->name(handle), handle)) {
+            return false;
+        }
+        const auto& entry = entries_[handle];
+        if (entry.placed) {
+            laneTasks[entry.lane].emplace_back(entry.placedAt, handle);
+        }
+        if (entry.deadlineIndexed) {
+            due.emplace_back(store_->deadline(handle), handle);
+        }
+    }
+    std::sort(due.begin(), due.end());
+    deadlines_.assign(due.begin(), due.end());
+    for (std::size_t lane = 0; lane < laneTasks.size(); ++lane) {
+        auto& target = (*lanes_)[lane];
+        std::sort(laneTasks[lane].begin(), laneTasks[lane].end());
+        std::vector<IntervalIndex::Item> busy;
+        busy.reserve(laneTasks[lane].size());
+        for (const auto& [start, handle] : laneTasks[lane]) {
+            busy.push_back(IntervalIndex::Item{handle, start, start + store_->duration(handle)});
+        }
+        target.placements.assign(laneTasks[lane].begin(), laneTasks[lane].end());
+        target.occupy(std::move(busy));
+    }
+    
+    // Task series
+    for (const auto& record : snapshot.column<Snapshot::SeriesRecord>(Section::SERIES)) {
+        auto name = loadText(text, record.textOffset, record.textLength);
+        auto rule = loadRule(record.rule, exceptions);
+        if (!name || !rule || record.priority > static_cast<std::uint8_t>(Priority::URGENT)) {
+            return false;
+        }
+        taskSeries_->emplace(*name, TaskSeries{Recurrence(fromTicks(record.firstDue), std::chrono::minutes(0), *rule),
+                                               std::chrono::minutes(record.duration),
+                                               static_cast<Priority>(record.priority),
+                                               fromTicks(record.expandedUntil)});
+    }
+    
+    // Dependencies. Both edge lists must describe the same edges, or removal
+    // would later search a list for an edge that is not there.
+    auto prerequisites = snapshot.column<Snapshot::Edge>(Section::PREREQUISITES);
+    auto dependents = snapshot.column<Snapshot::Edge>(Section::DEPENDENTS);
+    if (prerequisites.size() != dependents.size()) {
+        return false;
+    }
+    if (!prerequisites.empty()) {
+        std::vector<std::pair<TaskHandle, TaskHandle>> forward;
+        std::vector<std::pair<TaskHandle, TaskHandle>> backward;
+        links_.resize(capacity);
+        for (const auto& edge : prerequisites) {
+            if (!store_->isValid(edge.task) || !store_->isValid(edge.other) || edge.task == edge.other) {
+                return false;
+            }
+            links_[edge.task].prerequisites.push_back(edge.other);
+            forward.emplace_back(edge.other, edge.task);
+        }
+        for (const auto& edge : dependents) {
+            if (!store_->isValid(edge.task) || !store_->isValid(edge.other)) {
+                return false;
+            }
+            links_[edge.task].dependents.push_back(edge.other);
+            backward.emplace_back(edge.task, edge.other);
+        }
+        std::sort(forward.begin(), forward.end());
+        std::sort(backward.begin(), backward.end());
+        if (forward != backward || std::adjacent_find(forward.begin(), forward.end()) != forward.end()) {
+            return false;
+        }
+    }
+    dependencyCount_ = prerequisites.size();
+    dependencyCycle_ = header.dependencyCycle;
+    
+    auto timings = snapshot.column<Snapshot::Timing>(Section::TIMINGS);
+    auto criticalPath = snapshot.column<std::uint32_t>(Section::CRITICAL_PATH);
+    if (timings.size() > capacity) {
+        return false;
+    }
+    for (const auto& timing : timings) {
+        timings_->push_back(TaskTiming{std::chrono::minutes(timing.earliestStart),
+                                       std::chrono::minutes(timing.latestStart)});
+    }
+    for (auto handle : criticalPath) {
+        if (!store_->isValid(handle)) {
+            return false;
+        }
+        criticalPath_->push_back(handle);
+    }
+    
+    // Pass bookkeeping, exactly as saved
+    auto position = [&](const std::uint64_t (&saved)[2]) -> std::optional<Position> {
+        if (saved[0] >= kPriorityCount || saved[1] > buckets_[saved[0]].size()) {
+            return std::nullopt;
+        }
+        return Position{static_cast<std::size_t>(saved[0]), static_cast<std::size_t>(saved[1])};
+    };
+    dirty_.reset();
+    frontier_.reset();
+    if (header.hasDirty && !(dirty_ = position(header.dirty))) {
+        return false;
+    }
+    if (header.hasFrontier && !(frontier_ = position(header.frontier))) {
+        return false;
+    }
+    return true;
+}
+
+void TaskScheduler::reserveTasks(const std::array<std::size_t, kPriorityCount>& counts) {
+    std::size_t total = 0;
+    for (std::size_t b = 0; b < kPriorityCount; ++b) {
+        buckets_[b].reserve(buckets_[b].size() + counts[b]);
+        total += counts[b];
+    }
+    store_->reserve(store_->capacity() + total);
+    entries_.reserve(entries_.size() + total);
+    nameIndex_.reserve(nameIndex_.size() + total);
+}
+
+TaskScheduler::TaskHandle TaskScheduler::registerTask(TaskHandle handle) {
+    if (handle >= entries_.size()) {
+        entries_.resize(handle + 1);
+    }
+    entries_[handle] = Entry{};
+    nameIndex_.emplace(store_->name(handle), handle);
+    fileTask(handle, store_->priority(handle));
+    if (!store_->isCompleted(handle)) {
+        indexDeadline(handle);
+    }
+    return handle;
+}
+
+TaskScheduler::Lane::Lane(const std::chrono::minutes& granularity) {
+    if (granularity > std::chrono::minutes(0)) {
+        busy.emplace<BitmapTimeline>(granularity);
+    }
+}
+
+void TaskScheduler::Lane::occupy(IntervalIndex::Key key, const std::chrono::system_clock::time_point& start,
+                                 const std::chrono::system_clock::time_point& end) {
+    std::visit([&](auto& timeline) { timeline.insert(key, start, end); }, busy);
+}
+
+void TaskScheduler::Lane::occupy(std::vector<IntervalIndex::Item> items) {
+    if (auto* index = std::get_if<IntervalIndex>(&busy)) {
+        index->insert(std::move(items));
+        return;
+    }
+    for (const auto& item : items) {
+        std::get<BitmapTimeline>(busy).insert(item.key, item.start, item.end);
+    }
+}
+
+void TaskScheduler::Lane::vacate(IntervalIndex::Key key) {
+    std::visit([&](auto& timeline) { timeline.erase(key); }, busy);
+}
+
+bool TaskScheduler::Lane::isFree(const std::chrono::system_clock::time_point& start,
+                                 const std::chrono::system_clock::time_point& end) const {
+    if (!std::visit([&](const auto& timeline) { return timeline.isFree(start, end); }, busy)) {
+        return false;
+    }
+    for (const auto& [id, recurrence] : recurring) {
+        auto occurrence = recurrence->firstEndingAfter(start);
+        if (occurrence && *occurrence < end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The busy index jumps straight to the first gap that is long enough;
+// recurring events are kept in a heap by next occurrence, so a probe only
+// looks at the rules that can overlap it. Either may push the start later,
+// so alternate until neither does.
+//
+// Past the end of the busy time and of every rule's first occurrence,
+// exceptions and end date, the calendar repeats with the period of the
+// rules. A fit that is not found within one period never comes, and
+// time_point::max() is returned instead.
+std::chrono::system_clock::time_point TaskScheduler::Lane::findFirstFit(
+    const std::chrono::system_clock::time_point& from, const std::chrono::minutes& duration) const {
+    using TimePoint = std::chrono::system_clock::time_point;
+    using Next = std::pair<TimePoint, const Recurrence*>;
+    std::priority_queue<Next, std::vector<Next>, std::greater<>> next;
+    
+    auto settled = std::max(from, std::visit([](const auto& timeline) { return timeline.end(); }, busy));
+    std::int64_t period = 1;
+    for (const auto& [id, recurrence] : recurring) {
+        if (auto occurrence = recurrence->firstEndingAfter(from)) {
+            next.emplace(*occurrence, recurrence.get());
+        }
+        const auto& rule = recurrence->rule();
+        settled = std::max(settled, recurrence->first() + recurrence->length());
+        if (!rule.exceptions.empty()) {
+            settled = std::max(settled, *rule.exceptions.rbegin() + recurrence->length());
+        }
+        if (rule.until < TimePoint::max() - recurrence->length()) {
+            settled = std::max(settled, rule.until + recurrence->length());
+        }
+        // Weekday and interval patterns both repeat every 7 * interval days
+        period = std::min(std::lcm(period, std::int64_t(7) * rule.interval), kLongestPeriod.count());
+    }
+    auto giveUp = settled < TimePoint::max() - Days(period) ? settled + Days(period) : TimePoint::max();
+    
+    auto start = from;
+    while (start < giveUp) {
+        start = std::visit([&](const auto& timeline) { return timeline.findFirstFit(start, duration); }, busy);
+        auto blockedUntil = start;
+        while (!next.empty() && next.top().first < start + duration) {
+            auto [occurrence, recurrence] = next.top();
+            next.pop();
+            auto end = occurrence + recurrence->length();
+            if (end > start) {
+                blockedUntil = std::max(blockedUntil, end);
+            }
+            if (auto later = recurrence->firstEndingAfter(std::max(start, end))) {
+                next.emplace(*later, recurrence);
+            }
+        }
+        if (blockedUntil == start) {
+            return start;
+        }
+        start = blockedUntil;
+    }
+    return TimePoint::max();
+}
+
+void TaskScheduler::placeTask(TaskHandle handle, std::size_t lane,
+                              const std::chrono::system_clock::time_point& start) {
+    auto& entry = entries_[handle];
+    store_->setScheduledTime(handle, start);
+    entry.placed = true;
+    entry.deferred = false;
+    entry.lane = static_cast<std::uint32_t>(lane);
+    entry.placedAt = start;
+    (*lanes_)[lane].occupy(handle, start, start + store_->duration(handle));
+    (*lanes_)[lane].placements.insert({start, handle});
+    if (notifier_) {
+        notifier_->arm(handle, Notification::START, start);
+    }
+}
+
+void TaskScheduler::releaseTimeSlot(TaskHandle handle) {
+    auto& entry = entries_[handle];
+    if (!entry.placed) {
+        return;
+    }
+    
+    auto& lane = (*lanes_)[entry.lane];
+    lane.vacate(handle);
+    lane.placements.erase({entry.placedAt, handle});
+    entry.placed = false;
+    if (notifier_) {
+        notifier_->cancel(handle, Notification::START);
+    }
+}
+
+// Handles of the tasks starting in [from, to), by start time
+std::vector<TaskScheduler::TaskHandle> TaskScheduler::placedBetween(
+    const std::chrono::system_clock::time_point& from,
+    const std::chrono::system_clock::time_point& to) const {
+    std::vector<std::pair<std::chrono::system_clock::time_point, TaskHandle>> placed;
+    for (const auto& lane : *lanes_) {
+        for (auto it = lane.placements.lower_bound({from, 0}); it != lane.placements.end() && it->first < to; ++it) {
+            placed.emplace_back(it->first, it->second);
+        }
+    }
+    if (lanes_->size() > 1) {
+        std::stable_sort(placed.begin(), placed.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+    }
+    
+    std::vector<TaskHandle> result;
+    result.reserve(placed.size());
+    for (const auto& p : placed) {
+        result.push_back(p.second);
+    }
+    return result;
+}
+
+void TaskScheduler::blockLane(std::size_t lane, EventStore::Id id,
+                              const std::chrono::system_clock::time_point& start,
+                              const std::chrono::system_clock::time_point& end) {
+    const auto& placements = std::as_const(*lanes_)[lane].placements;
+    (*lanes_)[lane].occupy(kEventKeyBit | id, start, end);
+    
+    // Tasks overlapping the event have to move, and everything after them.
+    // An optimized lane need not be in scheduling order, so mark them all.
+    auto it = placements.lower_bound({start, 0});
+    if (it != placements.begin()) {
+        auto previous = std::prev(it);
+        if (previous->first + store_->duration(previous->second) > start) {
+            it = previous;
+        }
+    }
+    for (; it != placements.end() && it->first < end; ++it) {
+        markDirty(it->second);
+    }
+}
+
+void TaskScheduler::blockLane(std::size_t lane, EventStore::Id id,
+                              const std::shared_ptr<const Recurrence>& recurrence) {
+    auto& target = (*lanes_)[lane];
+    target.recurring.emplace(id, recurrence);
+    
+    // Occurrences can fall anywhere, so check every placement
+    for (const auto& [start, handle] : target.placements) {
+        auto occurrence = recurrence->firstEndingAfter(start);
+        if (occurrence && *occurrence < start + store_->duration(handle)) {
+            markDirty(handle);
+        }
+    }
+}
+
+void TaskScheduler::unblockLane(std::size_t lane, EventStore::Id id,
+                                const std::chrono::system_clock::time_point& start) {
+    // Tasks placed after the event may now fit earlier
+    const auto& placements = std::as_const(*lanes_)[lane].placements;
+    auto it = placements.lower_bound({start, 0});
+    if (it != placements.end()) {
+        markDirty(it->second);
+    }
+    (*lanes_)[lane].vacate(kEventKeyBit | id);
+    (*lanes_)[lane].recurring.erase(id);
+}
+
+// Creates the tasks of recurring occurrences that fell due within the
+// window. Series with nothing new are only read, so forks keep sharing them.
+void TaskScheduler::expandRecurringTasks(const std::chrono::system_clock::time_point& now) {
+    auto until = now + (horizon_ > std::chrono::minutes(0) ? horizon_ : kRecurrenceLookahead);
+    if (horizon_ > std::chrono::minutes(0)) {
+        until = std::max(until, horizonEnd_);
+    }
+    
+    std::vector<std::string> expanding;
+    for (const auto& [name, series] : *std::as_const(taskSeries_)) {
+        auto next = series.due.firstStartingAt(series.expandedUntil);
+        if (next && *next < until) {
+            expanding.push_back(name);
+        }
+    }
+    for (const auto& name : expanding) {
+        auto& series = taskSeries_->find(name)->second;
+        for (auto due = series.due.firstStartingAt(series.expandedUntil); due && *due < until;
+             due = series.due.firstStartingAt(*due + std::chrono::system_clock::duration(1))) {
+            addTask(name + "@" + toUtcDate(*due), series.duration, series.priority, *due);
+        }
+        series.expandedUntil = until;
+        if (journal_) {
+            journal_->logExpandRecurringTask(name, until);
+        }
+    }
+}
+
+void TaskScheduler::indexDeadline(TaskHandle handle) {
+    if (!std::as_const(entries_)[handle].deadlineIndexed) {
+        deadlines_.insert({store_->deadline(handle), handle});
+        entries_[handle].deadlineIndexed = true;
+        if (notifier_) {
+            notifier_->arm(handle, Notification::DEADLINE, store_->deadline(handle));
+        }
+    }
+}
+
+void TaskScheduler::dropDeadline(TaskHandle handle) {
+    if (std::as_const(entries_)[handle].deadlineIndexed) {
+        deadlines_.erase({store_->deadline(handle), handle});
+        entries_[handle].deadlineIndexed = false;
+        if (notifier_) {
+            notifier_->cancel(handle, Notification::DEADLINE);
+        }
+    }
+}
+
+void TaskScheduler::markDirty(TaskHandle handle) {
+    const auto& entry = std::as_const(entries_)[handle];
+    markDirty(Position{static_cast<std::size_t>(entry.bucket), entry.position});
+}
+
+void TaskScheduler::markDirty(const Position& position) {
+    if (!dirty_ || precedes(position, *dirty_)) {
+        dirty_ = position;
+    }
+}
+
+// Scheduling order: higher buckets first, then by index
+bool TaskScheduler::precedes(const Position& a, const Position& b) {
+    return a.bucket > b.bucket || (a.bucket == b.bucket && a.index < b.index);
+}
+
+TaskScheduler::Position TaskScheduler::endPosition() const {
+    return Position{0, buckets_[0].size()};
+}
+
+bool TaskScheduler::isBacklogged(TaskHandle handle) const {
+    const auto& entry = entries_[handle];
+    if (entry.placed || store_->isCompleted(handle)) {
+        return false;
+    }
+    return entry.deferred ||
+           (frontier_ && !precedes(Position{static_cast<std::size_t>(entry.bucket), entry.position}, *frontier_));
+}
+
+// Latest start a pass may hand out; the window never shrinks between passes
+std::chrono::system_clock::time_point TaskScheduler::passLimit(
+    const std::chrono::system_clock::time_point& now) {
+    if (horizon_ > std::chrono::minutes(0)) {
+        horizonEnd_ = std::max(horizonEnd_, now + horizon_);
+    }
+    return horizonEnd_;
+}
+
+void TaskScheduler::reflowFrom(const Position& position) {
+    if (dependencyCount_ > 0 || policy_ != SchedulingPolicy::PRIORITY) {
+        scheduleFull();
+        return;
+    }
+    timings_->clear();
+    criticalPath_->clear();
+    dependencyCycle_ = false;
+    
+    auto now = std::chrono::system_clock::now();
+    auto limit = passLimit(now);
+    TaskStore& store = *store_;
+    
+    // Everything from `position` on gets placed again. Nothing from the
+    // frontier on holds a slot, and placement resumes there at the latest.
+    auto backlog = frontier_ ? *frontier_ : endPosition();
+    auto start = precedes(backlog, position) ? backlog : position;
+    for (auto b = start.bucket + 1; b-- > 0;) {
+        const auto& bucket = std::as_const(buckets_)[b];
+        auto first = b == start.bucket ? start.index : 0;
+        for (auto i = first; i < bucket.size() && precedes(Position{b, i}, backlog); ++i) {
+            if (bucket[i] != TaskStore::kInvalidHandle) {
+                releaseTimeSlot(bucket[i]);
+            }
+        }
+    }
+    
+    // Every lane continues right after its last placement that is kept
+    using LaneCursor = std::pair<std::chrono::system_clock::time_point, std::size_t>;
+    std::vector<LaneCursor> cursors;
+    cursors.reserve(lanes_->size());
+    for (std::size_t lane = 0; lane < lanes_->size(); ++lane) {
+        auto cursor = now;
+        const auto& placements = std::as_const(*lanes_)[lane].placements;
+        if (!placements.empty()) {
+            auto last = std::prev(placements.end());
+            cursor = std::max(cursor, last->first + store.duration(last->second));
+        }
+        cursors.emplace_back(cursor, lane);
+    }
+    std::priority_queue<LaneCursor, std::vector<LaneCursor>, std::greater<LaneCursor>> freeLanes(
+        std::greater<LaneCursor>(), std::move(cursors));
+    
+    // Highest priority first, each task on the lane that frees up first,
+    // until the first task that would start beyond the horizon
+    for (auto b = start.bucket + 1; b-- > 0;) {
+        const auto& bucket = std::as_const(buckets_)[b];
+        auto first = b == start.bucket ? start.index : 0;
+        for (auto i = first; i < bucket.size(); ++i) {
+            auto handle = bucket[i];
+            if (handle == TaskStore::kInvalidHandle) {
+                continue;
+            }
+            if (store.isCompleted(handle)) {
+                store.setScheduledTime(handle, std::chrono::system_clock::time_point::min());
+                dropDeadline(handle);
+                continue;
+            }
+            indexDeadline(handle);
+            auto duration = store.duration(handle);
+            auto [cursor, lane] = freeLanes.top();
+            auto scheduledTime = findNextAvailableTimeSlot(lane, cursor, duration);
+            if (scheduledTime == std::chrono::system_clock::time_point::max()) {
+                // Recurring events leave no gap that fits; later tasks may fit
+                store.setScheduledTime(handle, std::chrono::system_clock::time_point::min());
+                continue;
+            }
+            if (scheduledTime >= limit) {
+                deferFrom(Position{b, i}, backlog);
+                dirty_.reset();
+                return;
+            }
+            freeLanes.pop();
+            placeTask(handle, lane, scheduledTime);
+            freeLanes.emplace(scheduledTime + duration, lane);
+        }
+    }
+    frontier_.reset();
+    dirty_.reset();
+}
+
+// Starts the backlog at `position`. Tasks up to the old frontier were
+// released by this pass and must not keep showing their old slots.
+void TaskScheduler::deferFrom(const Position& position, const Position& released) {
+    for (auto b = position.bucket + 1; b-- > 0;) {
+        const auto& bucket = std::as_const(buckets_)[b];
+        auto first = b == position.bucket ? position.index : 0;
+        for (auto i = first; i < bucket.size() && precedes(Position{b, i}, released); ++i) {
+            if (bucket[i] != TaskStore::kInvalidHandle) {
+                store_->setScheduledTime(bucket[i], std::chrono::system_clock::time_point::min());
+            }
+        }
+    }
+    frontier_ = position;
+}
+
+void TaskScheduler::fileTask(TaskHandle handle, Priority priority) {
+    auto& bucket = buckets_[static_cast<std::size_t>(priority)];
+    entries_[handle].bucket = priority;
+    entries_[handle].position = bucket.size();
+    bucket.push_back(handle);
+    markDirty(handle);
+}
+
+void TaskScheduler::unfileTask(TaskHandle handle) {
+    // Leave a hole so the rest of the bucket keeps its place and order
+    auto b = static_cast<std::size_t>(entries_[handle].bucket);
+    auto& bucket = buckets_[b];
+    auto position = entries_[handle].position;
+    bucket[position] = TaskStore::kInvalidHandle;
+    ++holes_[b];
+
+    // Everything after the hole may move up and needs a new slot
+    markDirty(Position{b, position});
+    if (2 * holes_[b] > bucket.size()) {
+        compactBucket(b);
+    }
+}
+
+// Drops the holes of a bucket. Costs O(bucket), paid for by the removals
+// that made at least half of it holes.
+void TaskScheduler::compactBucket(std::size_t b) {
+    auto& bucket = buckets_[b];
+    if (dirty_ && dirty_->bucket == b) {
+        dirty_->index = liveBefore(*dirty_);
+    }
+    if (frontier_ && frontier_->bucket == b) {
+        frontier_->index = liveBefore(*frontier_);
+    }
+    CowVector<TaskHandle> kept;
+    kept.reserve(bucket.size() - holes_[b]);
+    for (auto handle : bucket) {
+        if (handle != TaskStore::kInvalidHandle) {
+            entries_[handle].position = kept.size();
+            kept.push_back(handle);
+        }
+    }
+    bucket = kept;
+    holes_[b] = 0;
+}
+
+// Index `position` has once its bucket is compacted
+std::size_t TaskScheduler::liveBefore(const Position& position) const {
+    const auto& bucket = buckets_[position.bucket];
+    if (holes_[position.bucket] == 0) {
+        return position.index;
+    }
+    auto end = bucket.begin() + std::min(position.index, bucket.size());
+    return static_cast<std::size_t>(
+        std::count_if(bucket.begin(), end, [](TaskHandle handle) { return handle != TaskStore::kInvalidHandle; }));
+}
+
+void TaskScheduler::unlinkTask(TaskHandle handle) {
+    if (handle >= links_.size()) {
+        return;
+    }
+    
+    auto& links = links_[handle];
+    for (auto prerequisite : links.prerequisites) {
+        auto& dependents = links_[prerequisite].dependents;
+        dependents.erase(std::find(dependents.begin(), dependents.end(), handle));
+    }
+    for (auto dependent : links.dependents) {
+        auto& prerequisites = links_[dependent].prerequisites;
+        prerequisites.erase(std::find(prerequisites.begin(), prerequisites.end(), handle));
+        markDirty(dependent);
+    }
+    bool linked = !links.prerequisites.empty() || !links.dependents.empty();
+    dependencyCount_ -= links.prerequisites.size() + links.dependents.size();
+    links = Links{};
+    if (linked && dependencyCount_ == 0) {
+        markDirty(Position{kPriorityCount - 1, 0});
+    }
+    
+    // The critical path may run through this task
+    const auto& path = *std::as_const(criticalPath_);
+    if (std::find(path.begin(), path.end(), handle) != path.end()) {
+        criticalPath_->erase(std::remove(criticalPath_->begin(), criticalPath_->end(), handle), criticalPath_->end());
+    }
+}
+
+// Full pass used while dependencies exist or a deadline policy is selected:
+// topological order and critical path analysis first, then list scheduling
+// onto the lanes.
+void TaskScheduler::scheduleFull() {
+    auto now = std::chrono::system_clock::now();
+    auto limit = passLimit(now);
+    TaskStore& store = *store_;
+    std::size_t capacity = store.capacity();
+    links_.resize(std::max(links_.size(), capacity));
+    
+    for (auto& lane : *lanes_) {
+        for (const auto& placement : lane.placements) {
+            lane.vacate(placement.second);
+            entries_[placement.second].placed = false;
+            if (notifier_) {
+                notifier_->cancel(placement.second, Notification::START);
+            }
+        }
+        lane.placements.clear();
+    }
+    
+    // Pending tasks in scheduling order
+    std::vector<TaskHandle> pending;
+    std::vector<std::uint32_t> rank(capacity);
+    for (auto b = kPriorityCount; b-- > 0;) {
+        for (auto handle : buckets_[b]) {
+            if (handle == TaskStore::kInvalidHandle) {
+                continue;
+            }
+            if (store.isCompleted(handle)) {
+                store.setScheduledTime(handle, std::chrono::system_clock::time_point::min());
+                dropDeadline(handle);
+                continue;
+            }
+            indexDeadline(handle);
+            store.setScheduledTime(handle, std::chrono::system_clock::time_point::min());
+            entries_[handle].deferred = false;
+            rank[handle] = static_cast<std::uint32_t>(pending.size());
+            pending.push_back(handle);
+        }
+    }
+    
+    // Topological order (Kahn). Whatever is left over sits on or behind a cycle.
+    std::vector<std::uint32_t> waiting(capacity, 0);
+    for (auto handle : pending) {
+        for (auto prerequisite : links_[handle].prerequisites) {
+            if (!store.isCompleted(prerequisite)) {
+                ++waiting[handle];
+            }
+        }
+    }
+    std::vector<TaskHandle> order;
+    order.reserve(pending.size());
+    for (auto handle : pending) {
+        if (waiting[handle] == 0) {
+            order.push_back(handle);
+        }
+    }
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        for (auto dependent : links_[order[i]].dependents) {
+            if (!store.isCompleted(dependent) && --waiting[dependent] == 0) {
+                order.push_back(dependent);
+            }
+        }
+    }
+    dependencyCycle_ = order.size() < pending.size();
+    std::vector<std::uint8_t> planned(capacity, 0);
+    for (auto handle : order) {
+        planned[handle] = 1;
+    }
+    
+    // Critical path: earliest starts forward, latest starts backward
+    timings_->assign(capacity, TaskTiming{});
+    std::chrono::minutes makespan{0};
+    for (auto handle : order) {
+        auto finish = (*timings_)[handle].earliestStart + store.duration(handle);
+        makespan = std::max(makespan, finish);
+        for (auto dependent : links_[handle].dependents) {
+            if (planned[dependent]) {
+                (*timings_)[dependent].earliestStart = std::max((*timings_)[dependent].earliestStart, finish);
+            }
+        }
+    }
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        auto duration = store.duration(*it);
+        auto latest = makespan - duration;
+        for (auto dependent : links_[*it].dependents) {
+            if (planned[dependent]) {
+                latest = std::min(latest, (*timings_)[dependent].latestStart - duration);
+            }
+        }
+        (*timings_)[*it].latestStart = latest;
+    }
+    
+    // Deadline policies use effective deadlines: a task is due early enough
+    // for every dependent to still meet its own deadline
+    std::vector<std::chrono::system_clock::time_point> dueBy;
+    if (policy_ != SchedulingPolicy::PRIORITY) {
+        dueBy.resize(capacity);
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            auto due = store.deadline(*it);
+            for (auto dependent : links_[*it].dependents) {
+                if (planned[dependent]) {
+                    due = std::min(due, dueBy[dependent] - store.duration(dependent));
+                }
+            }
+            dueBy[*it] = due;
+        }
+    }
+    
+    criticalPath_->clear();
+    for (auto handle : order) {
+        if ((*timings_)[handle].earliestStart + store.duration(handle) == makespan &&
+            (*timings_)[handle].slack().count() == 0) {
+            criticalPath_->push_back(handle);
+            break;
+        }
+    }
+    while (!criticalPath_->empty()) {
+        auto current = criticalPath_->back();
+        TaskHandle next = TaskStore::kInvalidHandle;
+        for (auto prerequisite : links_[current].prerequisites) {
+            if (planned[prerequisite] && (*timings_)[prerequisite].slack().count() == 0 &&
+                (*timings_)[prerequisite].earliestStart + store.duration(prerequisite) ==
+                    (*timings_)[current].earliestStart) {
+                next = prerequisite;
+                break;
+            }
+        }
+        if (next == TaskStore::kInvalidHandle) {
+            break;
+        }
+        criticalPath_->push_back(next);
+    }
+    std::reverse(criticalPath_->begin(), criticalPath_->end());
+    
+    // List scheduling; each ready task goes to the lane that frees up first.
+    // Under PRIORITY ready tasks go by priority, then least slack (latest
+    // start), then scheduling order.
+    auto before = [&](TaskHandle a, TaskHandle b) {
+        if (policy_ == SchedulingPolicy::EARLIEST_DEADLINE && dueBy[a] != dueBy[b]) {
+            return dueBy[a] > dueBy[b];
+        }
+        if (policy_ == SchedulingPolicy::WEIGHTED_LATENESS) {
+            // Compare duration / weight without dividing, then fall back to EDF
+            auto scaledA = store.duration(a).count() * priorityWeight(store.priority(b));
+            auto scaledB = store.duration(b).count() * priorityWeight(store.priority(a));
+            if (scaledA != scaledB) {
+                return scaledA > scaledB;
+            }
+            if (dueBy[a] != dueBy[b]) {
+                return dueBy[a] > dueBy[b];
+            }
+        }
+        auto pa = store.priority(a);
+        auto pb = store.priority(b);
+        if (pa != pb) {
+            return pa < pb;
+        }
+        if ((*timings_)[a].latestStart != (*timings_)[b].latestStart) {
+            return (*timings_)[a].latestStart > (*timings_)[b].latestStart;
+        }
+        return rank[a] > rank[b];
+    };
+    std::priority_queue<TaskHandle, std::vector<TaskHandle>, decltype(before)> ready(before);
+    for (auto handle : order) {
+        for (auto prerequisite : links_[handle].prerequisites) {
+            if (planned[prerequisite]) {
+                ++waiting[handle];
+            }
+        }
+        if (waiting[handle] == 0) {
+            ready.push(handle);
+        }
+    }
+    
+    using LaneCursor = std::pair<std::chrono::system_clock::time_point, std::size_t>;
+    std::priority_queue<LaneCursor, std::vector<LaneCursor>, std::greater<LaneCursor>> freeLanes;
+    for (std::size_t lane = 0; lane < lanes_->size(); ++lane) {
+        freeLanes.emplace(now, lane);
+    }
+    std::vector<std::chrono::system_clock::time_point> readyAt(capacity, now);
+    
+    // Tasks that would start beyond the horizon stay in the backlog, and
+    // so does everything depending on them. Tasks no gap fits stay
+    // unplaced, as do their dependents, which never become ready.
+    bool deferred = false;
+    std::vector<std::uint8_t> unfit(capacity, 0);
+    while (!ready.empty()) {
+        auto handle = ready.top();
+        ready.pop();
+        auto [cursor, lane] = freeLanes.top();
+        if (cursor >= limit) {
+            deferred = true;
+            break;
+        }
+        
+        auto duration = store.duration(handle);
+        auto scheduledTime = findNextAvailableTimeSlot(lane, std::max(cursor, readyAt[handle]), duration);
+        if (scheduledTime == std::chrono::system_clock::time_point::max()) {
+            // Recurring events leave no gap that fits; later tasks may fit
+            unfit[handle] = 1;
+            continue;
+        }
+        if (scheduledTime >= limit) {
+            deferred = true;
+            continue;
+        }
+        freeLanes.pop();
+        placeTask(handle, lane, scheduledTime);
+        freeLanes.emplace(scheduledTime + duration, lane);
+        
+        for (auto dependent : links_[handle].dependents) {
+            if (planned[dependent]) {
+                readyAt[dependent] = std::max(readyAt[dependent], scheduledTime + duration);
+                if (--waiting[dependent] == 0) {
+                    ready.push(dependent);
+                }
+            }
+        }
+    }
+    
+    frontier_.reset();
+    if (deferred) {
+        for (auto handle : order) {
+            for (auto prerequisite : links_[handle].prerequisites) {
+                unfit[handle] |= planned[prerequisite] & unfit[prerequisite];
+            }
+            entries_[handle].deferred = !entries_[handle].placed && !unfit[handle];
+        }
+        frontier_ = endPosition();
+    }
+    dirty_.reset();
+}
+
+void TaskScheduler::eraseTask(TaskHandle handle) {
+    unlinkTask(handle);
+    estimates_.erase(handle);
+    releaseTimeSlot(handle);
+    dropDeadline(handle);
+    unfileTask(handle);
+    nameIndex_.erase(store_->name(handle));
+    if (notifier_) {
+        notifier_->forget(handle);
+    }
+    store_->destroy(handle);
+}
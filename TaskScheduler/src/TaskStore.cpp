@@ -0,0 +1,269 @@
+#include "../include/TaskStore.hpp"
+#include "../include/Task.hpp"
+#include "../include/Snapshot.hpp"
+
+namespace {
+
+const std::shared_ptr<const std::string>& noName() {
+    static const auto name = std::make_shared<const std::string>();
+    return name;
+}
+
+}
+
+TaskStore::~TaskStore() {
+    // Outstanding Task objects keep working with a copy of their values
+    for (auto& object : objects_) {
+        if (object) {
+            object->detach();
+        }
+    }
+}
+
+std::unique_ptr<TaskStore> TaskStore::fork() const {
+    auto copy = std::make_unique<TaskStore>();
+    copy->names_ = names_;
+    copy->durations_ = durations_;
+    copy->priorities_ = priorities_;
+    copy->deadlines_ = deadlines_;
+    copy->scheduledTimes_ = scheduledTimes_;
+    copy->completed_ = completed_;
+    copy->payloads_ = payloads_;
+    copy->live_ = live_;
+    copy->freeHandles_ = freeHandles_;
+    return copy;
+}
+
+// Time columns are saved as raw int64 ticks and restored by copying them
+// back in bulk, so they must be exactly that
+static_assert(sizeof(std::chrono::minutes) == sizeof(std::int64_t), "durations are stored as int64");
+static_assert(sizeof(TaskStore::TimePoint) == sizeof(std::int64_t), "times are stored as int64");
+
+void TaskStore::save(SnapshotWriter& writer) const {
+    using Section = Snapshot::Section;
+    std::size_t count = live_.size();
+
+    std::size_t textSize = 0;
+    for (const auto& name : names_) {
+        textSize += name->size();
+    }
+    std::vector<std::uint64_t> offsets;
+    std::vector<char> text;
+    offsets.reserve(count + 1);
+    text.reserve(textSize);
+    offsets.push_back(0);
+    for (const auto& name : names_) {
+        text.insert(text.end(), name->begin(), name->end());
+        offsets.push_back(text.size());
+    }
+    // Columns are paged, so they go out through contiguous copies
+    std::vector<std::int64_t> durations(count);
+    std::vector<std::uint8_t> priorities(count);
+    std::vector<std::int64_t> deadlines(count);
+    std::vector<std::int64_t> scheduledTimes(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        durations[i] = durations_[i].count();
+        priorities[i] = static_cast<std::uint8_t>(priorities_[i]);
+        deadlines[i] = deadlines_[i].time_since_epoch().count();
+        scheduledTimes[i] = scheduledTimes_[i].time_since_epoch().count();
+    }
+
+    writer.add(Section::TASK_NAME_OFFSETS, std::move(offsets));
+    writer.add(Section::TASK_NAMES, std::move(text));
+    writer.add(Section::DURATIONS, std::move(durations));
+    writer.add(Section::PRIORITIES, std::move(priorities));
+    writer.add(Section::DEADLINES, std::move(deadlines));
+    writer.add(Section::SCHEDULED_TIMES, std::move(scheduledTimes));
+    writer.add(Section::COMPLETED, std::vector<std::uint64_t>(completed_.begin(), completed_.end()));
+    writer.add(Section::LIVE, std::vector<std::uint8_t>(live_.begin(), live_.end()));
+}
+
+// Fixed-size columns are copied in bulk from the mapped records; only names
+// need one allocation per task.
+bool TaskStore::restore(const Snapshot& snapshot) {
+    using Section = Snapshot::Section;
+    auto offsets = snapshot.column<std::uint64_t>(Section::TASK_NAME_OFFSETS);
+    auto text = snapshot.column<char>(Section::TASK_NAMES);
+    auto durations = snapshot.column<std::int64_t>(Section::DURATIONS);
+    auto priorities = snapshot.column<std::uint8_t>(Section::PRIORITIES);
+    auto deadlines = snapshot.column<std::int64_t>(Section::DEADLINES);
+    auto scheduledTimes = snapshot.column<std::int64_t>(Section::SCHEDULED_TIMES);
+    auto completed = snapshot.column<std::uint64_t>(Section::COMPLETED);
+    auto live = snapshot.column<std::uint8_t>(Section::LIVE);
+
+    std::size_t count = live.size();
+    if (count >= kInvalidHandle || offsets.size() != count + 1 || durations.size() != count ||
+        priorities.size() != count || deadlines.size() != count || scheduledTimes.size() != count ||
+        completed.size() != (count + 63) / 64 || offsets[0] != 0 || offsets[count] > text.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1] || priorities[i] > static_cast<std::uint8_t>(Priority::URGENT) ||
+            live[i] > 1) {
+            return false;
+        }
+    }
+
+    // Every task owns its name: nameIndex_ of the scheduler views it and a
+    // rename replaces it on its own
+    names_.clear();
+    names_.reserve(count);
+    freeHandles_.clear();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (live[i]) {
+            names_.push_back(
+                std::make_shared<const std::string>(text.data() + offsets[i], offsets[i + 1] - offsets[i]));
+        } else {
+            names_.push_back(noName());
+            freeHandles_.push_back(static_cast<Handle>(i));
+        }
+    }
+    // Columns saved in their in-memory layout are copied a page at a time;
+    // priorities only widen from one byte
+    auto savedDurations = reinterpret_cast<const std::chrono::minutes*>(durations.data());
+    auto savedDeadlines = reinterpret_cast<const TimePoint*>(deadlines.data());
+    auto savedScheduledTimes = reinterpret_cast<const TimePoint*>(scheduledTimes.data());
+    durations_.assign(savedDurations, savedDurations + count);
+    deadlines_.assign(savedDeadlines, savedDeadlines + count);
+    scheduledTimes_.assign(savedScheduledTimes, savedScheduledTimes + count);
+    priorities_.clear();
+    priorities_.reserve(count);
+    for (auto priority : priorities) {
+        priorities_.push_back(static_cast<Priority>(priority));
+    }
+    completed_.assign(completed.begin(), completed.end());
+    live_.assign(live.begin(), live.end());
+    payloads_.assign(count, nullptr);
+    objects_.clear();
+    return true;
+}
+
+TaskStore::Handle TaskStore::create(const std::string& name, const std::chrono::minutes& duration,
+                                    Priority priority, const TimePoint& deadline) {
+    Handle handle;
+    if (!freeHandles_.empty()) {
+        handle = freeHandles_.back();
+        freeHandles_.pop_back();
+        names_[handle] = std::make_shared<const std::string>(name);
+        durations_[handle] = duration;
+        priorities_[handle] = priority;
+        deadlines_[handle] = deadline;
+        scheduledTimes_[handle] = TimePoint::min();
+        payloads_[handle] = nullptr;
+        live_[handle] = 1;
+    } else {
+        handle = static_cast<Handle>(live_.size());
+        names_.push_back(std::make_shared<const std::string>(name));
+        durations_.push_back(duration);
+        priorities_.push_back(priority);
+        deadlines_.push_back(deadline);
+        scheduledTimes_.push_back(TimePoint::min());
+        payloads_.emplace_back();
+        live_.push_back(1);
+        if ((handle >> 6) >= completed_.size()) {
+            completed_.push_back(0);
+        }
+    }
+    setCompleted(handle, false);
+    return handle;
+}
+
+void TaskStore::destroy(Handle handle) {
+    if (!isValid(handle)) {
+        return;
+    }
+    auto& object = objectSlot(handle);
+    if (object) {
+        object->detach();
+        object.reset();
+    }
+    names_[handle] = noName();
+    payloads_[handle] = nullptr;
+    setCompleted(handle, false);
+    live_[handle] = 0;
+    freeHandles_.push_back(handle);
+}
+
+void TaskStore::reserve(std::size_t count) {
+    names_.reserve(count);
+    durations_.reserve(count);
+    priorities_.reserve(count);
+    deadlines_.reserve(count);
+    scheduledTimes_.reserve(count);
+    payloads_.reserve(count);
+    completed_.reserve((count + 63) / 64);
+    live_.reserve(count);
+    objects_.reserve(count);
+}
+
+void TaskStore::setCompleted(Handle handle, bool completed) {
+    std::uint64_t bit = std::uint64_t(1) << (handle & 63);
+    if (completed) {
+        completed_[handle >> 6] |= bit;
+    } else {
+        completed_[handle >> 6] &= ~bit;
+    }
+}
+
+void TaskStore::changePriority(Handle handle, Priority priority) {
+    if (priorityHandler_) {
+        priorityHandler_(handle, priority);
+    } else {
+        setPriority(handle, priority);
+    }
+}
+
+void TaskStore::changeCompleted(Handle handle, bool completed) {
+    if (completionHandler_) {
+        completionHandler_(handle, completed);
+    } else {
+        setCompleted(handle, completed);
+    }
+}
+
+// Loads the task's values into the handle's columns and routes the task's
+// accessors through the store from now on.
+void TaskStore::bind(Handle handle, const std::shared_ptr<Task>& task) {
+    if (task->store_ && !(task->store_ == this && task->handle_ == handle)) {
+        // Bound somewhere else, so take its values along
+        TaskStore* previous = task->store_;
+        Handle previousHandle = task->handle_;
+        task->detach();
+        previous->objectSlot(previousHandle).reset();
+    }
+    auto& current = objectSlot(handle);
+    if (current && current != task) {
+        current->detach();
+    }
+
+    if (!task->store_) {
+        names_[handle] = std::make_shared<const std::string>(task->name_);
+        durations_[handle] = task->duration_;
+        priorities_[handle] = task->priority_;
+        deadlines_[handle] = task->deadline_;
+        scheduledTimes_[handle] = task->scheduled_time_;
+        setCompleted(handle, task->completed_);
+        payloads_[handle] = std::move(task->payload_);
+        task->store_ = this;
+        task->handle_ = handle;
+    }
+    current = task;
+}
+
+const std::shared_ptr<Task>& TaskStore::object(Handle handle) {
+    auto& object = objectSlot(handle);
+    if (!object) {
+        object = std::make_shared<Task>(name(handle), duration(handle), priority(handle), deadline(handle));
+        object->store_ = this;
+        object->handle_ = handle;
+    }
+    return object;
+}
+
+// Forks and bulk loads leave objects_ short; it catches up on first use
+std::shared_ptr<Task>& TaskStore::objectSlot(Handle handle) {
+    if (handle >= objects_.size()) {
+        objects_.resize(live_.size());
+    }
+    return objects_[handle];
+}
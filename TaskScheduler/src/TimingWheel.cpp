@@ -0,0 +1,117 @@
+#include "../include/TimingWheel.hpp"
+
+TimingWheel::TimingWheel(Tick now) : now_(now) {
+    for (auto& level : slots_) {
+        level.fill(kNone);
+    }
+}
+
+TimingWheel::TimerId TimingWheel::arm(Tick when, std::uint64_t payload) {
+    std::uint32_t index;
+    if (freeList_ != kNone) {
+        index = freeList_;
+        freeList_ = nodes_[index].next;
+    } else {
+        index = static_cast<std::uint32_t>(nodes_.size());
+        nodes_.push_back(Node{0, 0, kNone, kNone, 0, 0, 0, false});
+    }
+    auto& node = nodes_[index];
+    node.when = when;
+    node.payload = payload;
+    node.generation += 1;
+    node.armed = true;
+    link(index);
+    ++armed_;
+    return (TimerId(node.generation) << 32) | index;
+}
+
+bool TimingWheel::cancel(TimerId id) {
+    auto index = static_cast<std::uint32_t>(id);
+    if (index >= nodes_.size()) {
+        return false;
+    }
+    auto& node = nodes_[index];
+    if (!node.armed || node.generation != static_cast<std::uint32_t>(id >> 32)) {
+        return false;
+    }
+    unlink(index);
+    release(index);
+    return true;
+}
+
+std::optional<TimingWheel::Tick> TimingWheel::nextExpiry() const {
+    if (armed_ == 0) {
+        return std::nullopt;
+    }
+    auto position = static_cast<int>(now_ & (kSlots - 1));
+    if (occupied_[0] >> position) {
+        return now_ + (countTrailingZeros(occupied_[0] >> position));
+    }
+    // Higher levels only hold slots after the current digit; the first one
+    // occupied is where the next cascade happens
+    for (int level = 1; level < kLevels; ++level) {
+        auto digit = static_cast<int>((now_ >> (kBits * level)) & (kSlots - 1));
+        std::uint64_t ahead = digit + 1 < kSlots ? occupied_[level] >> (digit + 1) << (digit + 1) : 0;
+        if (ahead != 0) {
+            Tick base = now_ >> (kBits * (level + 1)) << (kBits * (level + 1));
+            return base + (Tick(countTrailingZeros(ahead)) << (kBits * level));
+        }
+    }
+    return ((now_ >> (kBits * kLevels)) + 1) << (kBits * kLevels);
+}
+
+std::uint32_t& TimingWheel::head(std::uint8_t level, std::uint8_t slot) {
+    return level == kOverflow ? overflow_ : slots_[level][slot];
+}
+
+void TimingWheel::link(std::uint32_t index) {
+    auto& node = nodes_[index];
+    Tick when = node.when > now_ ? node.when : now_;
+    auto differing = static_cast<std::uint64_t>(when ^ now_);
+    int level = differing == 0 ? 0 : (63 - countLeadingZeros(differing)) / kBits;
+    if (level >= kLevels) {
+        node.level = kOverflow;
+        node.slot = 0;
+    } else {
+        node.level = static_cast<std::uint8_t>(level);
+        node.slot = static_cast<std::uint8_t>((when >> (kBits * level)) & (kSlots - 1));
+        occupied_[level] |= std::uint64_t(1) << node.slot;
+    }
+    auto& first = head(node.level, node.slot);
+    node.prev = kNone;
+    node.next = first;
+    if (first != kNone) {
+        nodes_[first].prev = index;
+    }
+    first = index;
+}
+
+void TimingWheel::unlink(std::uint32_t index) {
+    auto& node = nodes_[index];
+    if (node.prev != kNone) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        head(node.level, node.slot) = node.next;
+    }
+    if (node.next != kNone) {
+        nodes_[node.next].prev = node.prev;
+    }
+    if (node.level != kOverflow && slots_[node.level][node.slot] == kNone) {
+        occupied_[node.level] &= ~(std::uint64_t(1) << node.slot);
+    }
+}
+
+std::uint32_t TimingWheel::takeSlot(int level, int slot) {
+    auto first = slots_[level][slot];
+    slots_[level][slot] = kNone;
+    occupied_[level] &= ~(std::uint64_t(1) << slot);
+    return first;
+}
+
+void TimingWheel::release(std::uint32_t index) {
+    auto& node = nodes_[index];
+    node.armed = false;
+    node.next = freeList_;
+    freeList_ = index;
+    --armed_;
+}
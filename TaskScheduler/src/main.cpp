@@ -55,9 +55,7 @@ int main() {
     );
     
     // Add tasks to scheduler
-    scheduler.addTask(task1);
-    scheduler.addTask(task2);
-    scheduler.addTask(task3);
+    scheduler.addTasks({task1, task2, task3});
     
     // Add a calendar event
     scheduler.addCalendarEvent(
@@ -91,5 +89,16 @@ int main() {
         printTask(task);
     }
     
+    // Run the remaining tasks on a thread pool
+    Executor executor;
+    task1->setPayload([] { std::cout << "Writing the project report\n"; });
+    task3->setPayload([] { std::cout << "Reviewing code\n"; });
+    scheduler.setCompletionCallback([](const std::shared_ptr<Task>& task) {
+        std::cout << "Finished: " << task->getName() << "\n";
+    });
+    scheduler.dispatchTasks(executor);
+    executor.wait();
+    scheduler.processCompletions();
+    
     return 0;
 } 
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <iostream>
+
+// Minimal assertions for the test executables: a failed CHECK prints where
+// it happened and makes checkResult() report failure, but the test carries
+// on so one run shows every broken expectation.
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+            ++checkFailures();                                                             \
+        }                                                                                  \
+    } while (false)
+
+inline int checkResult() {
+    if (checkFailures() != 0) {
+        std::cerr << checkFailures() << " check(s) failed\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "../include/TaskScheduler.hpp"
+#include "../include/Journal.hpp"
+#include "Check.hpp"
+#include <filesystem>
+
+namespace {
+
+using namespace std::chrono;
+
+void testEarliestDeadlineFirst() {
+    auto now = system_clock::now();
+    auto origin = floor<hours>(now) + hours(24);
+    TaskScheduler scheduler;
+    scheduler.setSchedulingPolicy(TaskScheduler::SchedulingPolicy::EARLIEST_DEADLINE);
+    scheduler.addCalendarEvent(now - hours(1), origin, "before");
+    auto late = scheduler.addTask("late", minutes(60), Priority::URGENT, origin + hours(3));
+    auto early = scheduler.addTask("early", minutes(30), Priority::LOW, origin + hours(1));
+    scheduler.scheduleTasks();
+
+    // Deadline order, not priority order
+    const auto& store = scheduler.getTaskStore();
+    CHECK(store.scheduledTime(early) == origin);
+    CHECK(store.scheduledTime(late) == origin + minutes(30));
+    CHECK(scheduler.getFeasibilityReport().feasible);
+}
+
+void testAdmission() {
+    auto now = system_clock::now();
+    auto origin = floor<hours>(now) + hours(24);
+    TaskScheduler scheduler;
+    scheduler.setSchedulingPolicy(TaskScheduler::SchedulingPolicy::EARLIEST_DEADLINE);
+    scheduler.addCalendarEvent(now - hours(1), origin, "before");
+    scheduler.addTask("a", minutes(60), Priority::MEDIUM, origin + minutes(60));
+    scheduler.addTask("b", minutes(60), Priority::MEDIUM, origin + minutes(120));
+    scheduler.scheduleTasks();
+
+    // Fits after both
+    CHECK(scheduler.admitTask(std::make_shared<Task>("c", minutes(30), Priority::LOW, origin + hours(4))));
+    // Would go before b and make it late
+    CHECK(!scheduler.admitTask(std::make_shared<Task>("d", minutes(30), Priority::LOW, origin + minutes(90))));
+    CHECK(scheduler.findTask("d") == TaskStore::kInvalidHandle);
+    CHECK(scheduler.getFeasibilityReport().feasible);
+    // Names must be new
+    CHECK(!scheduler.admitTask(std::make_shared<Task>("c", minutes(1), Priority::LOW, origin + hours(9))));
+
+    // A task already late may not get later, even though the number of
+    // late tasks stays the same
+    scheduler.addTask("overdue", minutes(60), Priority::MEDIUM, origin + minutes(150));
+    scheduler.rescheduleTasks();
+    auto report = scheduler.getFeasibilityReport();
+    CHECK(!report.feasible && report.maxLateness == minutes(30));
+    CHECK(!scheduler.admitTask(std::make_shared<Task>("e", minutes(10), Priority::LOW, origin + minutes(140))));
+    CHECK(scheduler.getFeasibilityReport().maxLateness == minutes(30));
+    CHECK(scheduler.admitTask(std::make_shared<Task>("f", minutes(10), Priority::LOW, origin + hours(9))));
+}
+
+
+// A rejected task is only tried on a fork: nothing is journaled and no
+// placement moves
+void testRejectionLeavesNoTrace() {
+    auto now = system_clock::now();
+    auto origin = floor<hours>(now) + hours(24);
+    auto directory = (std::filesystem::temp_directory_path() / "task_scheduler_admission").string();
+    std::filesystem::remove_all(directory);
+    {
+        Journal journal(directory);
+        auto scheduler = journal.recover();
+        scheduler->addCalendarEvent(now - hours(1), origin, "before");
+        auto a = scheduler->addTask("a", minutes(60), Priority::MEDIUM, origin + minutes(60));
+        scheduler->scheduleTasks();
+        auto logged = journal.lastSequence();
+        
+        CHECK(!scheduler->admitTask(std::make_shared<Task>("b", minutes(30), Priority::URGENT, origin + hours(9))));
+        CHECK(journal.lastSequence() == logged);
+        CHECK(scheduler->getTaskStore().scheduledTime(a) == origin);
+        CHECK(scheduler->getTaskCount() == 1);
+        
+        CHECK(scheduler->admitTask(std::make_shared<Task>("c", minutes(30), Priority::LOW, origin + hours(9))));
+        CHECK(journal.lastSequence() == logged + 1);
+    }
+    std::filesystem::remove_all(directory);
+}
+
+}
+
+int main() {
+    testEarliestDeadlineFirst();
+    testAdmission();
+    testRejectionLeavesNoTrace();
+    return checkResult();
+}
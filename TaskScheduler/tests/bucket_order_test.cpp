@@ -0,0 +1,171 @@
+#include "../include/TaskScheduler.hpp"
+#include "Check.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono;
+
+std::vector<std::string> names(const TaskScheduler& scheduler, Priority priority) {
+    std::vector<std::string> result;
+    for (auto handle : scheduler.getTaskHandlesByPriority(priority)) {
+        result.push_back(scheduler.getTaskStore().name(handle));
+    }
+    return result;
+}
+
+// Placements follow the buckets: one lane, back to back
+std::vector<std::string> placementOrder(TaskScheduler& scheduler) {
+    std::vector<std::pair<system_clock::time_point, std::string>> placed;
+    for (auto priority : {Priority::URGENT, Priority::HIGH, Priority::MEDIUM, Priority::LOW}) {
+        for (auto handle : scheduler.getTaskHandlesByPriority(priority)) {
+            placed.emplace_back(scheduler.getTaskStore().scheduledTime(handle), scheduler.getTaskStore().name(handle));
+        }
+    }
+    std::sort(placed.begin(), placed.end());
+    std::vector<std::string> result;
+    for (const auto& p : placed) {
+        result.push_back(p.second);
+    }
+    return result;
+}
+
+void testRemovalKeepsInsertionOrder() {
+    TaskScheduler scheduler;
+    auto deadline = system_clock::now() + hours(24);
+    for (auto name : {"a", "b", "c", "d", "e"}) {
+        scheduler.addTask(name, minutes(10), Priority::MEDIUM, deadline);
+    }
+    scheduler.scheduleTasks();
+
+    scheduler.removeTask("b");
+    CHECK(names(scheduler, Priority::MEDIUM) == (std::vector<std::string>{"a", "c", "d", "e"}));
+    scheduler.removeTask(scheduler.findTask("a"));
+    CHECK(names(scheduler, Priority::MEDIUM) == (std::vector<std::string>{"c", "d", "e"}));
+
+    scheduler.rescheduleTasks();
+    CHECK(placementOrder(scheduler) == (std::vector<std::string>{"c", "d", "e"}));
+    const auto& store = scheduler.getTaskStore();
+    CHECK(store.scheduledTime(scheduler.findTask("d")) ==
+          store.scheduledTime(scheduler.findTask("c")) + minutes(10));
+}
+
+void testPriorityChangesRefile() {
+    TaskScheduler scheduler;
+    auto deadline = system_clock::now() + hours(24);
+    for (auto name : {"a", "b", "c", "d"}) {
+        scheduler.addTask(name, minutes(10), Priority::MEDIUM, deadline);
+    }
+    scheduler.addTask("x", minutes(10), Priority::HIGH, deadline);
+    scheduler.scheduleTasks();
+
+    // The task joins the end of its new bucket; bystanders keep their order
+    CHECK(scheduler.changePriority("b", Priority::HIGH));
+    CHECK(names(scheduler, Priority::HIGH) == (std::vector<std::string>{"x", "b"}));
+    CHECK(names(scheduler, Priority::MEDIUM) == (std::vector<std::string>{"a", "c", "d"}));
+
+    // Task::setPriority goes through the scheduler too
+    scheduler.getTask("a")->setPriority(Priority::URGENT);
+    CHECK(names(scheduler, Priority::URGENT) == (std::vector<std::string>{"a"}));
+    CHECK(names(scheduler, Priority::MEDIUM) == (std::vector<std::string>{"c", "d"}));
+
+    // The current priority changes nothing, not even the position
+    CHECK(scheduler.changePriority("x", Priority::HIGH));
+    CHECK(names(scheduler, Priority::HIGH) == (std::vector<std::string>{"x", "b"}));
+    CHECK(!scheduler.changePriority("missing", Priority::LOW));
+
+    scheduler.rescheduleTasks();
+    CHECK(placementOrder(scheduler) == (std::vector<std::string>{"a", "x", "b", "c", "d"}));
+
+    // Bouncing a task between buckets leaves holes behind in both, which
+    // get compacted along the way
+    for (int i = 0; i < 50; ++i) {
+        CHECK(scheduler.changePriority("c", i % 2 == 0 ? Priority::LOW : Priority::MEDIUM));
+    }
+    CHECK(names(scheduler, Priority::MEDIUM) == (std::vector<std::string>{"d", "c"}));
+    CHECK(names(scheduler, Priority::LOW).empty());
+    CHECK(scheduler.getTasksByPriority(Priority::LOW).empty());
+    scheduler.rescheduleTasks();
+    CHECK(placementOrder(scheduler) == (std::vector<std::string>{"a", "x", "b", "d", "c"}));
+}
+
+
+// Removals leave holes until half of a bucket is holes. Views, copies,
+// snapshots and the backlog of a horizon bounded pass all skip them.
+void testHolesAndCompaction() {
+    auto now = system_clock::now();
+    auto origin = now + hours(1);
+    TaskScheduler scheduler;
+    scheduler.addCalendarEvent(now - hours(1), origin, "before");
+    // Nine tasks start within the horizon
+    scheduler.setSchedulingHorizon(hours(5) + minutes(15));
+    std::vector<std::string> kept;
+    for (int i = 0; i < 40; ++i) {
+        auto name = "t" + std::to_string(i);
+        scheduler.addTask(name, minutes(30), Priority::MEDIUM, origin + hours(48));
+        if (i % 3 != 1) {
+            kept.push_back(name);
+        }
+    }
+    scheduler.scheduleTasks();
+    CHECK(scheduler.getTaskLane(scheduler.findTask("t8")));
+    CHECK(!scheduler.getTaskLane(scheduler.findTask("t9")));
+
+    // Fewer than half holes: nothing is compacted yet
+    for (int i = 1; i < 40; i += 3) {
+        scheduler.removeTask("t" + std::to_string(i));
+    }
+    CHECK(names(scheduler, Priority::MEDIUM) == kept);
+    auto view = scheduler.getTasksByPriority(Priority::MEDIUM);
+    CHECK(view.size() == kept.size());
+    std::vector<std::string> viewed;
+    for (const auto& task : view) {
+        viewed.push_back(task->getName());
+    }
+    CHECK(viewed == kept);
+    CHECK((*std::prev(view.end()))->getName() == kept.back());
+
+    auto path = "task_scheduler_holes.snapshot";
+    CHECK(scheduler.saveSnapshot(path));
+    auto loaded = TaskScheduler::loadSnapshot(path);
+    CHECK(loaded && names(*loaded, Priority::MEDIUM) == kept);
+    std::remove(path);
+
+    // Nine tasks fit the horizon again, in bucket order
+    scheduler.rescheduleTasks();
+    std::vector<std::string> placed = placementOrder(scheduler);
+    auto unplaced = [&](const std::string& name) { return !scheduler.getTaskLane(scheduler.findTask(name)); };
+    placed.erase(std::remove_if(placed.begin(), placed.end(), unplaced), placed.end());
+    CHECK(placed == std::vector<std::string>(kept.begin(), kept.begin() + 9));
+
+    // Past half, the bucket is compacted; the backlog stays behind the same task
+    for (std::size_t i = 0; i < kept.size(); i += 2) {
+        scheduler.removeTask(kept[i]);
+    }
+    std::vector<std::string> left;
+    for (std::size_t i = 1; i < kept.size(); i += 2) {
+        left.push_back(kept[i]);
+    }
+    CHECK(names(scheduler, Priority::MEDIUM) == left);
+    CHECK(scheduler.getTasksByPriority(Priority::MEDIUM).size() == left.size());
+    scheduler.addTask("late", minutes(30), Priority::MEDIUM, origin + hours(48));
+    CHECK(!scheduler.getTaskLane(scheduler.findTask("late")));
+    scheduler.rescheduleTasks();
+    for (std::size_t i = 0; i < left.size(); ++i) {
+        CHECK(scheduler.getTaskLane(scheduler.findTask(left[i])).has_value() == (i < 9));
+    }
+    CHECK(!scheduler.getTaskLane(scheduler.findTask("late")));
+}
+
+}
+
+int main() {
+    testRemovalKeepsInsertionOrder();
+    testPriorityChangesRefile();
+    testHolesAndCompaction();
+    return checkResult();
+}
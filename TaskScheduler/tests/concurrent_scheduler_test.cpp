@@ -0,0 +1,79 @@
+#include "../include/ConcurrentScheduler.hpp"
+#include "Check.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono;
+
+void testProducersAndSnapshots() {
+    auto deadline = system_clock::now() + hours(24 * 30);
+    ConcurrentScheduler scheduler;
+    CHECK(scheduler.snapshot()->size() == 0);
+
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 250;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                auto name = "t" + std::to_string(t) + "-" + std::to_string(i);
+                scheduler.addTask(std::make_shared<Task>(name, minutes(5), static_cast<Priority>(i % 4), deadline));
+            }
+        });
+    }
+
+    // Readers only ever see whole batches; sizes never go backwards
+    std::atomic<bool> producing{true};
+    std::atomic<bool> ordered{true};
+    std::thread reader([&] {
+        std::size_t last = 0;
+        std::uint64_t version = 0;
+        while (producing) {
+            auto snapshot = scheduler.snapshot();
+            std::size_t listed = 0;
+            for (auto priority : {Priority::URGENT, Priority::HIGH, Priority::MEDIUM, Priority::LOW}) {
+                listed += snapshot->tasks(priority).size();
+            }
+            if (snapshot->size() < last || snapshot->version < version || listed != snapshot->size()) {
+                ordered = false;
+            }
+            last = snapshot->size();
+            version = snapshot->version;
+        }
+    });
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    scheduler.flush();
+    producing = false;
+    reader.join();
+    CHECK(ordered);
+
+    auto before = scheduler.snapshot();
+    CHECK(before->size() == kThreads * kPerThread);
+    auto info = before->find("t2-6");
+    CHECK(info && info->priority == Priority::HIGH && info->duration == minutes(5) && !info->completed);
+    CHECK(info && info->scheduledTime != system_clock::time_point::min());
+    CHECK(!before->find("missing"));
+
+    // Later batches do not change a snapshot already taken
+    scheduler.completeTask("t2-6");
+    scheduler.removeTask("t0-0");
+    scheduler.flush();
+    auto after = scheduler.snapshot();
+    CHECK(after->version > before->version);
+    CHECK(after->size() == before->size() - 1);
+    CHECK(after->find("t2-6") && after->find("t2-6")->completed);
+    CHECK(before->find("t0-0") && !before->find("t2-6")->completed);
+}
+
+}
+
+int main() {
+    testProducersAndSnapshots();
+    return checkResult();
+}
@@ -0,0 +1,197 @@
+#include "../include/CowHashMap.hpp"
+#include "../include/CowSet.hpp"
+#include "../include/CowVector.hpp"
+#include "Check.hpp"
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+template <typename T>
+bool same(const CowVector<T>& vector, const std::vector<T>& model) {
+    return vector.size() == model.size() && std::equal(vector.begin(), vector.end(), model.begin());
+}
+
+template <typename T>
+bool same(const CowSet<T>& set, const std::multiset<T>& model) {
+    return set.size() == model.size() && std::equal(set.begin(), set.end(), model.begin());
+}
+
+bool same(const CowHashMap<int, int>& map, const std::unordered_map<int, int>& model) {
+    if (map.size() != model.size()) {
+        return false;
+    }
+    for (const auto& [key, value] : model) {
+        const int* found = map.find(key);
+        if (!found || *found != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copies taken along the way keep their contents while both sides are
+// written to, including writes to pages the copies still share.
+void testVectorCopies() {
+    std::mt19937 random(1);
+    CowVector<int> vector;
+    std::vector<int> model;
+    std::vector<std::pair<CowVector<int>, std::vector<int>>> copies;
+
+    for (int round = 0; round < 4000; ++round) {
+        switch (random() % 6) {
+        case 0:
+        case 1:
+            vector.push_back(round);
+            model.push_back(round);
+            break;
+        case 2:
+            if (!model.empty()) {
+                vector.pop_back();
+                model.pop_back();
+            }
+            break;
+        case 3:
+            if (!model.empty()) {
+                auto index = random() % model.size();
+                vector[index] = -round;
+                model[index] = -round;
+            }
+            break;
+        case 4:
+            if (round % 50 == 0) {
+                copies.emplace_back(vector, model);
+            }
+            break;
+        default:
+            if (!copies.empty()) {
+                auto& [copy, copyModel] = copies[random() % copies.size()];
+                if (!copyModel.empty()) {
+                    auto index = random() % copyModel.size();
+                    copy[index] = round;
+                    copyModel[index] = round;
+                }
+            }
+            break;
+        }
+    }
+    CHECK(same(vector, model));
+    for (const auto& [copy, copyModel] : copies) {
+        CHECK(same(copy, copyModel));
+    }
+
+    CowVector<int> filled;
+    filled.assign(model.begin(), model.end());
+    CHECK(same(filled, model));
+    filled.resize(3);
+    filled.assign(1000, 7);
+    CHECK(filled.size() == 1000 && filled[999] == 7 && filled.back() == 7);
+    CHECK(same(vector, model));
+}
+
+// Duplicates, splits of full pages and merges of emptied ones
+void testSetCopies() {
+    std::mt19937 random(2);
+    CowSet<int> set;
+    std::multiset<int> model;
+    std::vector<std::pair<CowSet<int>, std::multiset<int>>> copies;
+
+    for (int round = 0; round < 20000; ++round) {
+        int value = static_cast<int>(random() % 3000);
+        if (round < 10000 ? random() % 3 != 0 : random() % 3 == 0) {
+            set.insert(value);
+            model.insert(value);
+        } else {
+            CHECK(set.erase(value) == (model.count(value) > 0));
+            auto found = model.find(value);
+            if (found != model.end()) {
+                model.erase(found);
+            }
+        }
+        if (round % 1000 == 0) {
+            copies.emplace_back(set, model);
+        }
+    }
+    CHECK(same(set, model));
+    for (const auto& [copy, copyModel] : copies) {
+        CHECK(same(copy, copyModel));
+    }
+
+    for (int value : {-1, 0, 1500, 2999, 3000}) {
+        auto lower = set.lower_bound(value);
+        auto upper = set.upper_bound(value);
+        auto modelLower = model.lower_bound(value);
+        auto modelUpper = model.upper_bound(value);
+        CHECK((lower == set.end()) == (modelLower == model.end()));
+        CHECK((upper == set.end()) == (modelUpper == model.end()));
+        if (lower != set.end() && modelLower != model.end()) {
+            CHECK(*lower == *modelLower);
+        }
+        if (upper != set.end() && modelUpper != model.end()) {
+            CHECK(*upper == *modelUpper);
+        }
+    }
+
+    // Appending in order fills pages, and the walk back matches too
+    CowSet<int> sorted;
+    std::vector<int> values(5000);
+    for (int i = 0; i < 5000; ++i) {
+        values[i] = i / 2;
+        sorted.insert(i / 2);
+    }
+    CowSet<int> assigned;
+    assigned.assign(values.begin(), values.end());
+    CHECK(std::equal(sorted.begin(), sorted.end(), values.begin(), values.end()));
+    CHECK(std::equal(assigned.begin(), assigned.end(), values.begin(), values.end()));
+    CHECK(*std::prev(assigned.end()) == values.back());
+}
+
+// Growth rehashes into more shards while older copies keep theirs
+void testHashMapCopies() {
+    std::mt19937 random(3);
+    CowHashMap<int, int> map;
+    std::unordered_map<int, int> model;
+    std::vector<std::pair<CowHashMap<int, int>, std::unordered_map<int, int>>> copies;
+
+    for (int round = 0; round < 20000; ++round) {
+        int key = static_cast<int>(random() % 8000);
+        switch (random() % 3) {
+        case 0:
+            CHECK(map.emplace(key, round) == model.emplace(key, round).second);
+            break;
+        case 1:
+            map.insertOrAssign(key, round);
+            model[key] = round;
+            break;
+        default:
+            CHECK(map.erase(key) == (model.erase(key) > 0));
+            break;
+        }
+        if (round % 2000 == 0) {
+            copies.emplace_back(map, model);
+        }
+    }
+    CHECK(same(map, model));
+    CHECK(map.count(-1) == 0 && map.find(-1) == nullptr);
+    for (const auto& [copy, copyModel] : copies) {
+        CHECK(same(copy, copyModel));
+    }
+
+    map.clear();
+    CHECK(map.empty() && map.find(1) == nullptr);
+    CHECK(same(copies.back().first, copies.back().second));
+}
+
+}
+
+int main() {
+    testVectorCopies();
+    testSetCopies();
+    testHashMapCopies();
+    return checkResult();
+}
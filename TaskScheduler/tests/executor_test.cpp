@@ -0,0 +1,101 @@
+#include "../include/Executor.hpp"
+#include "Check.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+void testRunsEveryJob() {
+    Executor executor(4);
+    std::atomic<int> sum{0};
+    for (int i = 1; i <= 1000; ++i) {
+        executor.submit([&sum, i] { sum += i; }, i % 10 == 0 ? Priority::URGENT : Priority::MEDIUM);
+    }
+    executor.wait();
+    CHECK(sum == 500500);
+
+    // Jobs submitted from jobs, and jobs that throw
+    std::atomic<int> nested{0};
+    for (int i = 0; i < 10; ++i) {
+        executor.submit([&] {
+            for (int j = 0; j < 10; ++j) {
+                executor.submit([&nested] { ++nested; });
+            }
+            throw 1;
+        });
+    }
+    executor.wait();
+    CHECK(nested == 100);
+}
+
+// A batch waits for its own jobs only, not for a job that never finishes
+// while the batch runs
+void testBatchIgnoresOtherJobs() {
+    Executor executor(2);
+    std::mutex mutex;
+    std::condition_variable released;
+    bool release = false;
+    executor.submit([&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        released.wait(lock, [&] { return release; });
+    });
+
+    std::atomic<int> done{0};
+    {
+        Executor::Batch batch(executor);
+        for (int i = 0; i < 100; ++i) {
+            batch.submit([&done] { ++done; });
+        }
+        batch.wait();
+        CHECK(done == 100);
+        batch.submit([&done] { ++done; });
+    }
+    CHECK(done == 101);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    released.notify_all();
+    executor.wait();
+}
+
+
+// Queued jobs run by priority, first in first out within a level
+void testPriorityOrder() {
+    Executor executor(1);
+    std::mutex mutex;
+    std::condition_variable released;
+    bool release = false;
+    executor.submit([&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        released.wait(lock, [&] { return release; });
+    });
+
+    std::vector<int> order;
+    const Priority priorities[] = {Priority::LOW, Priority::HIGH, Priority::MEDIUM,
+                                   Priority::URGENT, Priority::HIGH, Priority::LOW};
+    for (int i = 0; i < 6; ++i) {
+        // Only the one worker touches `order`
+        executor.submit([&order, i] { order.push_back(i); }, priorities[i]);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    released.notify_all();
+    executor.wait();
+    CHECK((order == std::vector<int>{3, 1, 4, 2, 0, 5}));
+}
+
+}
+
+int main() {
+    testRunsEveryJob();
+    testBatchIgnoresOtherJobs();
+    testPriorityOrder();
+    return checkResult();
+}
@@ -0,0 +1,98 @@
+#include "../include/IntervalIndex.hpp"
+#include "../include/BitmapTimeline.hpp"
+#include "Check.hpp"
+#include <random>
+#include <vector>
+
+namespace {
+
+using TimePoint = IntervalIndex::TimePoint;
+using std::chrono::minutes;
+
+const TimePoint kBase = TimePoint(std::chrono::hours(24 * 20000));
+
+TimePoint at(int minute) {
+    return kBase + minutes(minute);
+}
+
+void testGapSearch() {
+    IntervalIndex index;
+    CHECK(index.findFirstFit(at(0), minutes(30)) == at(0));
+    CHECK(index.end() == TimePoint::min());
+
+    index.insert(1, at(0), at(60));
+    index.insert(2, at(90), at(120));
+    index.insert(3, at(100), at(200));   // overlaps 2
+    index.insert(4, at(260), at(300));
+
+    CHECK(index.findFirstFit(at(0), minutes(30)) == at(60));
+    CHECK(index.findFirstFit(at(0), minutes(31)) == at(200));
+    CHECK(index.findFirstFit(at(0), minutes(60)) == at(200));
+    CHECK(index.findFirstFit(at(0), minutes(61)) == at(300));
+    CHECK(index.findFirstFit(at(70), minutes(20)) == at(70));
+    CHECK(index.findFirstFit(at(-30), minutes(30)) == at(-30));
+    CHECK(index.end() == at(300));
+    CHECK(!index.isFree(at(110), at(130)));
+    CHECK(index.isFree(at(200), at(260)));
+
+    // Erasing one of two overlapping intervals keeps the other's busy time
+    CHECK(index.erase(3));
+    CHECK(!index.erase(3));
+    CHECK(index.isFree(at(120), at(260)));
+    CHECK(index.findFirstFit(at(0), minutes(61)) == at(120));
+    CHECK(!index.isFree(at(90), at(91)));
+}
+
+// Same answers as a per-minute model, for the index and the bitmap
+void testAgainstModel() {
+    constexpr int kSpan = 2000;
+    std::mt19937 random(7);
+    IntervalIndex index;
+    BitmapTimeline bitmap(minutes(1));
+    std::vector<std::pair<int, int>> intervals(200, {0, 0});
+    std::vector<bool> present(intervals.size());
+
+    auto freeInModel = [&](int from, int to) {
+        for (std::size_t key = 0; key < intervals.size(); ++key) {
+            if (present[key] && intervals[key].first < to && from < intervals[key].second) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (int step = 0; step < 2000; ++step) {
+        auto key = random() % intervals.size();
+        if (present[key]) {
+            CHECK(index.erase(key));
+            CHECK(bitmap.erase(key));
+            present[key] = false;
+        } else {
+            int start = static_cast<int>(random() % kSpan);
+            int length = 1 + static_cast<int>(random() % 40);
+            intervals[key] = {start, start + length};
+            index.insert(key, at(start), at(start + length));
+            bitmap.insert(key, at(start), at(start + length));
+            present[key] = true;
+        }
+
+        int from = static_cast<int>(random() % kSpan);
+        int duration = 1 + static_cast<int>(random() % 30);
+        int expected = from;
+        while (!freeInModel(expected, expected + duration)) {
+            ++expected;
+        }
+        CHECK(index.findFirstFit(at(from), minutes(duration)) == at(expected));
+        CHECK(bitmap.findFirstFit(at(from), minutes(duration)) == at(expected));
+        CHECK(index.isFree(at(from), at(from + duration)) == freeInModel(from, from + duration));
+        CHECK(bitmap.isFree(at(from), at(from + duration)) == freeInModel(from, from + duration));
+    }
+}
+
+}
+
+int main() {
+    testGapSearch();
+    testAgainstModel();
+    return checkResult();
+}
@@ -0,0 +1,191 @@
+#include "../include/TaskScheduler.hpp"
+#include "../include/Journal.hpp"
+#include "Check.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono;
+
+std::string freshDirectory(const std::string& name) {
+    auto path = (std::filesystem::temp_directory_path() / name).string();
+    std::filesystem::remove_all(path);
+    return path;
+}
+
+std::vector<std::string> oneOffEvents(const TaskScheduler& scheduler, system_clock::time_point from) {
+    std::vector<std::string> result;
+    for (const auto& event : scheduler.getCalendarEvents(from, from + hours(24))) {
+        if (event.description != "standup") {
+            result.push_back(event.description);
+        }
+    }
+    return result;
+}
+
+// Occurrences of the "backup" series, by due date
+std::vector<TaskScheduler::TaskHandle> backups(const TaskScheduler& scheduler) {
+    const auto& store = scheduler.getTaskStore();
+    std::vector<TaskScheduler::TaskHandle> result;
+    for (auto priority : {Priority::LOW, Priority::MEDIUM, Priority::HIGH, Priority::URGENT}) {
+        for (auto handle : scheduler.getTaskHandlesByPriority(priority)) {
+            if (store.name(handle).rfind("backup@", 0) == 0) {
+                result.push_back(handle);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [&store](auto a, auto b) { return store.deadline(a) < store.deadline(b); });
+    return result;
+}
+
+void testTaskRoundTrip() {
+    auto directory = freshDirectory("task_scheduler_journal_tasks");
+    auto deadline = floor<minutes>(system_clock::now()) + hours(8);
+    {
+        Journal journal(directory);
+        auto scheduler = journal.recover();
+        scheduler->addTask("write", minutes(30), Priority::LOW, deadline);
+        scheduler->addTask("review", minutes(45), Priority::HIGH, deadline);
+        scheduler->addTask("drop", minutes(10), Priority::MEDIUM, deadline);
+        scheduler->changePriority("write", Priority::URGENT);
+        scheduler->completeTask("review");
+        scheduler->removeTask("drop");
+        
+        // Completion through bound Task objects, and taking it back
+        auto done = std::make_shared<Task>("done", minutes(20), Priority::LOW, deadline);
+        auto reopened = std::make_shared<Task>("reopened", minutes(20), Priority::LOW, deadline);
+        scheduler->addTask(done);
+        scheduler->addTask(reopened);
+        done->setCompleted(true);
+        reopened->setCompleted(true);
+        reopened->setCompleted(false);
+        CHECK(journal.sync());
+    }
+    Journal journal(directory);
+    auto recovered = journal.recover();
+    CHECK(recovered->getTaskStore().isCompleted(recovered->findTask("done")));
+    CHECK(!recovered->getTaskStore().isCompleted(recovered->findTask("reopened")));
+    recovered->removeTask("done");
+    recovered->removeTask("reopened");
+    CHECK(recovered->getTaskCount() == 2);
+    CHECK(recovered->findTask("drop") == TaskStore::kInvalidHandle);
+    auto write = recovered->findTask("write");
+    auto review = recovered->findTask("review");
+    CHECK(write != TaskStore::kInvalidHandle && review != TaskStore::kInvalidHandle);
+    CHECK(recovered->getTaskStore().priority(write) == Priority::URGENT);
+    CHECK(recovered->getTaskStore().deadline(write) == deadline);
+    CHECK(recovered->getTaskStore().isCompleted(review));
+    std::filesystem::remove_all(directory);
+}
+
+// Recurring events and lane events dropped with their lane take event ids
+// too; removals by id must still hit the same events after replay
+void testEventIdsSurviveReplay() {
+    auto directory = freshDirectory("task_scheduler_journal_events");
+    auto day = floor<hours>(system_clock::now()) + hours(48);
+    EventStore::Id d;
+    {
+        Journal journal(directory);
+        auto scheduler = journal.recover();
+        scheduler->addCalendarEvent(day, day + hours(1), "a");
+        scheduler->addRecurringEvent(day + hours(9), day + hours(10), "standup", RecurrenceRule{});
+        auto b = scheduler->addCalendarEvent(day + hours(2), day + hours(3), "b");
+        scheduler->setLaneCount(2);
+        scheduler->addCalendarEvent(day + hours(4), day + hours(5), "c", 1);
+        scheduler->setLaneCount(1);
+        d = scheduler->addCalendarEvent(day + hours(6), day + hours(7), "d");
+        scheduler->addCalendarEvent(day + hours(8), day + hours(9), "e");
+        CHECK(scheduler->removeCalendarEvent(b));
+        CHECK(oneOffEvents(*scheduler, day) == (std::vector<std::string>{"a", "d", "e"}));
+        CHECK(journal.sync());
+    }
+    {
+        // The replayed events carry the ids handed out before
+        Journal journal(directory);
+        auto recovered = journal.recover();
+        CHECK(oneOffEvents(*recovered, day) == (std::vector<std::string>{"a", "d", "e"}));
+        CHECK(recovered->removeCalendarEvent(d));
+        CHECK(journal.sync());
+    }
+    Journal journal(directory);
+    auto recovered = journal.recover();
+    CHECK(oneOffEvents(*recovered, day) == (std::vector<std::string>{"a", "e"}));
+    std::filesystem::remove_all(directory);
+}
+
+
+// Settings, dependencies and recurring rules are journaled too, so lane
+// events replay onto the right lane count and compaction keeps all of it
+void testSettingsSurviveReplay() {
+    auto directory = freshDirectory("task_scheduler_journal_settings");
+    auto day = floor<hours>(system_clock::now()) + hours(48);
+    std::size_t made = 0;
+    auto check = [&](TaskScheduler& scheduler) {
+        CHECK(scheduler.getLaneCount() == 3);
+        CHECK(scheduler.getTimeGranularity() == minutes(15));
+        CHECK(scheduler.getSchedulingPolicy() == TaskScheduler::SchedulingPolicy::EARLIEST_DEADLINE);
+        CHECK(scheduler.getSchedulingHorizon() == hours(24 * 7));
+        CHECK(oneOffEvents(scheduler, day) == (std::vector<std::string>{"lane 2"}));
+        auto events = scheduler.getCalendarEvents(day, day + hours(24));
+        CHECK(std::count_if(events.begin(), events.end(),
+                            [](const CalendarEvent& event) { return event.description == "standup"; }) == 1);
+        CHECK(scheduler.getDependencyCount() == 1);
+        
+        // Occurrences made before the crash are not made again, and keep
+        // their state
+        scheduler.rescheduleTasks();
+        CHECK(backups(scheduler).size() == made);
+        CHECK(!scheduler.addRecurringTask("backup", minutes(5), Priority::LOW, day, RecurrenceRule{}));
+        CHECK(scheduler.getTaskStore().isCompleted(backups(scheduler).front()));
+    };
+    {
+        Journal journal(directory);
+        auto scheduler = journal.recover();
+        scheduler->setLaneCount(3);
+        scheduler->setTimeGranularity(minutes(15));
+        scheduler->setSchedulingPolicy(TaskScheduler::SchedulingPolicy::EARLIEST_DEADLINE);
+        scheduler->setSchedulingHorizon(hours(24 * 7));
+        scheduler->addCalendarEvent(day + hours(1), day + hours(2), "lane 2", 2);
+        scheduler->addRecurringEvent(day + hours(9), day + hours(10), "standup", RecurrenceRule{});
+        scheduler->addTask("build", minutes(30), Priority::LOW, day + hours(8));
+        scheduler->addTask("ship", minutes(30), Priority::LOW, day + hours(8));
+        scheduler->addTask("test", minutes(30), Priority::LOW, day + hours(8));
+        scheduler->addDependency("ship", "build");
+        scheduler->addDependency("test", "build");
+        scheduler->removeDependency("test", "build");
+        scheduler->addRecurringTask("backup", minutes(5), Priority::LOW, day, RecurrenceRule{});
+        scheduler->addRecurringTask("gone", minutes(5), Priority::LOW, day, RecurrenceRule{});
+        scheduler->removeRecurringTask("gone");
+        scheduler->setSchedulingHorizon(hours(24 * 28));
+        scheduler->setSchedulingHorizon(hours(24 * 7));
+        scheduler->scheduleTasks();
+        made = backups(*scheduler).size();
+        CHECK(made >= 5);
+        scheduler->completeTask(backups(*scheduler).front());
+        CHECK(journal.sync());
+    }
+    {
+        Journal journal(directory);
+        auto recovered = journal.recover();
+        check(*recovered);
+        CHECK(journal.compact());
+        CHECK(journal.waitForCompaction());
+    }
+    Journal journal(directory);
+    auto recovered = journal.recover();
+    check(*recovered);
+    std::filesystem::remove_all(directory);
+}
+
+}
+
+int main() {
+    testTaskRoundTrip();
+    testEventIdsSurviveReplay();
+    testSettingsSurviveReplay();
+    return checkResult();
+}
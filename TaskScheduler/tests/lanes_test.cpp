@@ -0,0 +1,66 @@
+#include "../include/TaskScheduler.hpp"
+#include "Check.hpp"
+
+namespace {
+
+using namespace std::chrono;
+
+void testParallelLanes() {
+    auto now = system_clock::now();
+    auto origin = floor<hours>(now) + hours(24);
+    TaskScheduler scheduler;
+    scheduler.setLaneCount(2);
+    scheduler.addCalendarEvent(now - hours(1), origin, "before");
+    auto a = scheduler.addTask("a", minutes(60), Priority::HIGH, origin + hours(4));
+    auto b = scheduler.addTask("b", minutes(60), Priority::HIGH, origin + hours(4));
+    auto c = scheduler.addTask("c", minutes(30), Priority::LOW, origin + hours(4));
+    scheduler.scheduleTasks();
+
+    const auto& store = scheduler.getTaskStore();
+    CHECK(store.scheduledTime(a) == origin && store.scheduledTime(b) == origin);
+    CHECK(scheduler.getTaskLane(a) && scheduler.getTaskLane(b));
+    CHECK(scheduler.getTaskLane(a) != scheduler.getTaskLane(b));
+    CHECK(store.scheduledTime(c) == origin + hours(1));
+
+    // An event on one lane moves only what it overlaps there
+    auto lane = *scheduler.getTaskLane(a);
+    auto meeting = scheduler.addCalendarEvent(origin, origin + hours(2), "meeting", lane);
+    CHECK(meeting != EventStore::kInvalidId);
+    scheduler.rescheduleTasks();
+    bool otherLaneStarts = false;
+    for (auto handle : {a, b, c}) {
+        auto placedOn = scheduler.getTaskLane(handle);
+        CHECK(placedOn);
+        if (placedOn && *placedOn == lane) {
+            CHECK(store.scheduledTime(handle) >= origin + hours(2));
+        } else if (placedOn && store.scheduledTime(handle) == origin) {
+            otherLaneStarts = true;
+        }
+    }
+    CHECK(otherLaneStarts);
+}
+
+// Events for lanes that do not exist are refused instead of blocking all
+void testUnknownLanes() {
+    auto origin = floor<hours>(system_clock::now()) + hours(24);
+    TaskScheduler scheduler;
+    scheduler.setLaneCount(2);
+    CHECK(scheduler.addCalendarEvent(origin, origin + hours(1), "x", 2) == EventStore::kInvalidId);
+    CHECK(scheduler.addRecurringEvent(origin, origin + hours(1), "y", RecurrenceRule{}, 7) == EventStore::kInvalidId);
+    CHECK(scheduler.getCalendarEvents(origin - hours(1), origin + hours(48)).empty());
+
+    // Shrinking drops the events of lanes that are gone
+    scheduler.addCalendarEvent(origin, origin + hours(1), "second", 1);
+    scheduler.addCalendarEvent(origin + hours(2), origin + hours(3), "all");
+    scheduler.setLaneCount(1);
+    auto events = scheduler.getCalendarEvents(origin - hours(1), origin + hours(48));
+    CHECK(events.size() == 1 && events[0].description == "all");
+}
+
+}
+
+int main() {
+    testParallelLanes();
+    testUnknownLanes();
+    return checkResult();
+}
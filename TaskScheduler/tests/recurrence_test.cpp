@@ -0,0 +1,159 @@
+#include "../include/Recurrence.hpp"
+#include "../include/TaskScheduler.hpp"
+#include "Check.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono;
+using TimePoint = Recurrence::TimePoint;
+using Days = duration<std::int64_t, std::ratio<86400>>;
+
+// 2024-01-01 09:00 UTC, a Monday
+const TimePoint kMonday = TimePoint(duration_cast<system_clock::duration>(Days(19723) + hours(9)));
+
+// Occurrence starts by walking day by day through the rule
+std::vector<TimePoint> model(const TimePoint& first, const RecurrenceRule& rule, int days) {
+    int firstWeekday = static_cast<int>((duration_cast<Days>(first.time_since_epoch()).count() + 4) % 7);
+    unsigned weekdays = rule.weekdays & 0x7f;
+    if (weekdays == 0) {
+        weekdays = rule.frequency == RecurrenceRule::Frequency::WEEKLY ? 1u << firstWeekday : 0x7f;
+    }
+    unsigned interval = std::max(rule.interval, 1u);
+    std::vector<TimePoint> starts;
+    for (int day = 0; day < days; ++day) {
+        auto start = first + Days(day);
+        int weekday = (firstWeekday + day) % 7;
+        bool repeats = rule.frequency == RecurrenceRule::Frequency::DAILY
+                           ? day % interval == 0
+                           : ((firstWeekday + day) / 7) % interval == 0;
+        if (repeats && (weekdays >> weekday & 1) && start < rule.until && !rule.exceptions.count(start)) {
+            starts.push_back(start);
+        }
+    }
+    return starts;
+}
+
+void testExpansion() {
+    std::mt19937 random(3);
+    for (int round = 0; round < 300; ++round) {
+        RecurrenceRule rule;
+        rule.frequency = random() % 2 ? RecurrenceRule::Frequency::WEEKLY : RecurrenceRule::Frequency::DAILY;
+        rule.interval = 1 + random() % 4;
+        rule.weekdays = static_cast<std::uint8_t>(random() % 3 ? random() % 128 : 0);
+        auto first = kMonday + Days(random() % 7) + minutes(random() % 600);
+        if (random() % 2) {
+            rule.until = first + Days(20 + random() % 60);
+        }
+        auto all = model(first, rule, 400);
+        for (int i = 0; i < 3 && !all.empty(); ++i) {
+            rule.exceptions.insert(all[random() % all.size()]);
+        }
+        auto length = minutes(30 + random() % 120);
+        Recurrence recurrence(first, length, rule);
+        // Far enough out that the model holds the next occurrence after any probe
+        auto expected = model(first, rule, 400);
+
+        // overlapping() lists exactly the model's occurrences
+        std::vector<TimePoint> starts;
+        recurrence.overlapping(first - hours(1), first + Days(100), starts);
+        std::vector<TimePoint> inRange;
+        for (const auto& start : expected) {
+            if (start < first + Days(100)) {
+                inRange.push_back(start);
+            }
+        }
+        CHECK(starts == inRange);
+
+        // Point queries agree with the model
+        auto probe = first + minutes(random() % (60 * 24 * 90));
+        std::optional<TimePoint> ending;
+        std::optional<TimePoint> starting;
+        for (const auto& start : expected) {
+            if (!ending && start + length > probe) {
+                ending = start;
+            }
+            if (!starting && start >= probe) {
+                starting = start;
+            }
+        }
+        CHECK(recurrence.firstEndingAfter(probe) == ending);
+        CHECK(recurrence.firstStartingAt(probe) == starting);
+    }
+}
+
+void testWeeklyInterval() {
+    RecurrenceRule rule;
+    rule.frequency = RecurrenceRule::Frequency::WEEKLY;
+    rule.interval = 2;
+    rule.weekdays = 0x22;   // Monday and Friday
+    Recurrence recurrence(kMonday, hours(1), rule);
+    std::vector<TimePoint> starts;
+    recurrence.overlapping(kMonday, kMonday + Days(28), starts);
+    CHECK(starts == (std::vector<TimePoint>{kMonday, kMonday + Days(4), kMonday + Days(14), kMonday + Days(18)}));
+}
+
+// Slot searches wait out recurring events, and give up when they never end
+void testSlotsAroundRecurringEvents() {
+    auto day = floor<hours>(system_clock::now()) - hours(24 * 3);
+    TaskScheduler scheduler;
+    scheduler.addRecurringEvent(day, day + hours(23), "blocked", RecurrenceRule{});
+    auto tooLong = scheduler.addTask("long", hours(2), Priority::HIGH, day + hours(24 * 30));
+    auto fits = scheduler.addTask("short", minutes(30), Priority::LOW, day + hours(24 * 30));
+    scheduler.scheduleTasks();
+
+    const auto& store = scheduler.getTaskStore();
+    CHECK(!scheduler.getTaskLane(tooLong));
+    CHECK(scheduler.getTaskLane(fits));
+    auto start = store.scheduledTime(fits);
+    auto sinceMidnight = (start - day) % hours(24);
+    CHECK(sinceMidnight >= hours(23) && sinceMidnight <= hours(23) + minutes(30));
+    CHECK(start >= system_clock::now() - hours(24));
+}
+
+// A task no gap fits stays unplaced in a full pass too, rather than going
+// to the horizon backlog, where it would look on time
+void testNoFitWithHorizon() {
+    auto day = floor<hours>(system_clock::now()) - hours(24 * 3);
+    TaskScheduler scheduler;
+    scheduler.setSchedulingHorizon(hours(48));
+    scheduler.addRecurringEvent(day, day + hours(23), "blocked", RecurrenceRule{});
+    auto tooLong = scheduler.addTask("long", hours(2), Priority::HIGH, day + hours(24 * 30));
+    auto fits = scheduler.addTask("short", minutes(30), Priority::LOW, day + hours(24 * 30));
+    auto after = scheduler.addTask("after", minutes(30), Priority::LOW, day + hours(24 * 30));
+    scheduler.addDependency(after, fits);
+    scheduler.scheduleTasks();
+
+    CHECK(!scheduler.getTaskLane(tooLong));
+    CHECK(scheduler.getTaskLane(fits));
+    auto report = scheduler.getFeasibilityReport();
+    CHECK(!report.feasible);
+    CHECK(report.lateTasks.size() == 1 && report.lateTasks[0].task->getName() == "long");
+    CHECK(report.maxLateness == minutes::max());
+
+    // Something really deferred, then the horizon lifted before the next
+    // pass: its lateness is taken from an unbounded horizon end. The only
+    // gap each day starts 23 hours into it, beyond a one minute horizon.
+    scheduler.setSchedulingHorizon(minutes(1));
+    scheduler.rescheduleTasks();
+    CHECK(!scheduler.getTaskLane(fits) && !scheduler.getTaskLane(after));
+    CHECK(scheduler.getFeasibilityReport().lateTasks.size() == 1);
+    scheduler.setSchedulingHorizon(minutes(0));
+    report = scheduler.getFeasibilityReport();
+    CHECK(report.lateTasks.size() == 3);
+    for (const auto& late : report.lateTasks) {
+        CHECK(late.lateness == minutes::max());
+    }
+}
+
+}
+
+int main() {
+    testExpansion();
+    testWeeklyInterval();
+    testSlotsAroundRecurringEvents();
+    testNoFitWithHorizon();
+    return checkResult();
+}
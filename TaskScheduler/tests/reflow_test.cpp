@@ -0,0 +1,107 @@
+#include "../include/TaskScheduler.hpp"
+#include "Check.hpp"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono;
+
+// Every live task has the same slot and lane in both schedulers
+bool samePlacements(TaskScheduler& incremental, TaskScheduler& full) {
+    const auto& a = incremental.getTaskStore();
+    const auto& b = full.getTaskStore();
+    for (auto priority : {Priority::URGENT, Priority::HIGH, Priority::MEDIUM, Priority::LOW}) {
+        const auto& handles = incremental.getTaskHandlesByPriority(priority);
+        if (handles != full.getTaskHandlesByPriority(priority)) {
+            return false;
+        }
+        for (auto handle : handles) {
+            if (a.scheduledTime(handle) != b.scheduledTime(handle) ||
+                incremental.getTaskLane(handle) != full.getTaskLane(handle)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void testIncrementalMatchesFull(std::size_t lanes) {
+    std::mt19937 random(static_cast<unsigned>(11 + lanes));
+    auto now = system_clock::now();
+    auto origin = floor<hours>(now) + hours(24);
+
+    TaskScheduler scheduler;
+    scheduler.setLaneCount(lanes);
+    // Nothing starts before the origin, so passes at different times agree
+    scheduler.addCalendarEvent(now - hours(1), origin, "before");
+
+    std::vector<std::string> tasks;
+    std::vector<EventStore::Id> events;
+    const Priority priorities[] = {Priority::LOW, Priority::MEDIUM, Priority::HIGH, Priority::URGENT};
+    for (int i = 0; i < 40; ++i) {
+        tasks.push_back("task" + std::to_string(i));
+        scheduler.addTask(tasks.back(), minutes(15 + 15 * (random() % 6)), priorities[random() % 4],
+                          origin + hours(random() % 48));
+    }
+    scheduler.scheduleTasks();
+
+    int next = 40;
+    for (int round = 0; round < 200; ++round) {
+        switch (random() % 6) {
+            case 0:
+                tasks.push_back("task" + std::to_string(next++));
+                scheduler.addTask(tasks.back(), minutes(15 + 15 * (random() % 6)), priorities[random() % 4],
+                                  origin + hours(random() % 48));
+                break;
+            case 1:
+                if (!tasks.empty()) {
+                    auto at = random() % tasks.size();
+                    scheduler.removeTask(tasks[at]);
+                    tasks.erase(tasks.begin() + at);
+                }
+                break;
+            case 2:
+                if (!tasks.empty()) {
+                    scheduler.completeTask(tasks[random() % tasks.size()]);
+                }
+                break;
+            case 3:
+                if (!tasks.empty()) {
+                    scheduler.changePriority(tasks[random() % tasks.size()], priorities[random() % 4]);
+                }
+                break;
+            case 4: {
+                auto start = origin + minutes(15 * (random() % 200));
+                auto end = start + minutes(15 + 15 * (random() % 8));
+                if (lanes > 1 && random() % 2) {
+                    events.push_back(scheduler.addCalendarEvent(start, end, "busy", random() % lanes));
+                } else {
+                    events.push_back(scheduler.addCalendarEvent(start, end, "busy"));
+                }
+                break;
+            }
+            case 5:
+                if (!events.empty()) {
+                    auto at = random() % events.size();
+                    scheduler.removeCalendarEvent(events[at]);
+                    events.erase(events.begin() + at);
+                }
+                break;
+        }
+        scheduler.rescheduleTasks();
+
+        auto full = scheduler.fork();
+        full->scheduleTasks();
+        CHECK(samePlacements(scheduler, *full));
+    }
+}
+
+}
+
+int main() {
+    testIncrementalMatchesFull(1);
+    testIncrementalMatchesFull(3);
+    return checkResult();
+}
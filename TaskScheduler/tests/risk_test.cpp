@@ -0,0 +1,70 @@
+#include "../include/TaskScheduler.hpp"
+#include "../include/Executor.hpp"
+#include "Check.hpp"
+
+namespace {
+
+using namespace std::chrono;
+
+void addPlan(TaskScheduler& scheduler, system_clock::time_point origin) {
+    scheduler.addCalendarEvent(origin - hours(48), origin, "before");
+    auto first = scheduler.addTask("first", minutes(60), Priority::HIGH, origin + minutes(90));
+    scheduler.addTask("second", minutes(60), Priority::MEDIUM, origin + hours(4));
+    scheduler.setDurationEstimate(first, {minutes(30), minutes(60), minutes(180)});
+    scheduler.scheduleTasks();
+}
+
+void testPercentiles() {
+    auto origin = floor<hours>(system_clock::now()) + hours(24);
+    TaskScheduler scheduler;
+    addPlan(scheduler, origin);
+    Executor executor(2);
+    TaskScheduler::RiskOptions options;
+    options.iterations = 2000;
+    options.samples = 500;
+    auto report = scheduler.simulateRisk(executor, options);
+
+    CHECK(report.tasks.size() == 2);
+    CHECK(report.tasks[0].task->getName() == "first");
+    // Only the slow tail of the first task misses its deadline
+    CHECK(report.tasks[0].missProbability > 0 && report.tasks[0].missProbability < 1);
+    CHECK(report.tasks[1].missProbability == 0);
+    CHECK(report.tasks[0].p50Finish > origin + minutes(30));
+    CHECK(report.tasks[0].p50Finish <= report.tasks[0].p90Finish);
+    CHECK(report.tasks[0].p90Finish <= origin + minutes(180));
+    CHECK(report.p90Finish == report.tasks[1].p90Finish);
+}
+
+void testNoSamples() {
+    auto origin = floor<hours>(system_clock::now()) + hours(24);
+    TaskScheduler scheduler;
+    addPlan(scheduler, origin);
+    Executor executor(2);
+    TaskScheduler::RiskOptions options;
+    options.iterations = 2000;
+    options.samples = 0;
+    auto report = scheduler.simulateRisk(executor, options);
+
+    // Misses are still counted, the percentiles are left out
+    CHECK(report.tasks.size() == 2);
+    CHECK(report.tasks[0].missProbability > 0 && report.tasks[0].missProbability < 1);
+    CHECK(report.tasks[0].p50Finish == system_clock::time_point{});
+    CHECK(report.tasks[1].p90Finish == system_clock::time_point{});
+    CHECK(report.p50Finish == system_clock::time_point{});
+    CHECK(report.p90Finish == system_clock::time_point{});
+
+    options.iterations = 0;
+    options.samples = 16;
+    report = scheduler.simulateRisk(executor, options);
+    CHECK(report.tasks.size() == 2);
+    CHECK(report.tasks[0].missProbability == 0);
+    CHECK(report.p90Finish == system_clock::time_point{});
+}
+
+}
+
+int main() {
+    testPercentiles();
+    testNoSamples();
+    return checkResult();
+}
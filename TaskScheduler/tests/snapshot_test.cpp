@@ -0,0 +1,93 @@
+#include "../include/TaskScheduler.hpp"
+#include "Check.hpp"
+#include <filesystem>
+#include <string>
+
+namespace {
+
+using namespace std::chrono;
+
+void testRoundTrip() {
+    auto path = (std::filesystem::temp_directory_path() / "task_scheduler_snapshot_test").string();
+    auto now = system_clock::now();
+    auto origin = floor<hours>(now) + hours(24);
+
+    TaskScheduler scheduler;
+    scheduler.setLaneCount(2);
+    scheduler.setSchedulingHorizon(hours(24 * 7));
+    scheduler.addCalendarEvent(now - hours(1), origin, "before");
+    auto meeting = scheduler.addCalendarEvent(origin + hours(1), origin + hours(2), "meeting", 1);
+    RecurrenceRule weekdays;
+    weekdays.weekdays = 0x3e;
+    auto standup = scheduler.addRecurringEvent(origin + hours(9), origin + hours(9) + minutes(15), "standup",
+                                               weekdays);
+    for (int i = 0; i < 20; ++i) {
+        scheduler.addTask("task" + std::to_string(i), minutes(20 + 5 * i), static_cast<Priority>(i % 4),
+                          origin + hours(i));
+    }
+    scheduler.removeTask("task3");
+    scheduler.completeTask("task5");
+    scheduler.addDependency("task7", "task8");
+    scheduler.scheduleTasks();
+    CHECK(scheduler.saveSnapshot(path));
+
+    auto loaded = TaskScheduler::loadSnapshot(path);
+    CHECK(loaded != nullptr);
+    if (!loaded) {
+        return;
+    }
+    CHECK(loaded->getTaskCount() == scheduler.getTaskCount());
+    CHECK(loaded->getLaneCount() == 2);
+    CHECK(loaded->getSchedulingHorizon() == hours(24 * 7));
+    CHECK(loaded->getDependencyCount() == 1);
+    CHECK(loaded->findTask("task3") == TaskStore::kInvalidHandle);
+
+    // Same handles, values and slots
+    const auto& before = scheduler.getTaskStore();
+    const auto& after = loaded->getTaskStore();
+    for (auto priority : {Priority::URGENT, Priority::HIGH, Priority::MEDIUM, Priority::LOW}) {
+        const auto& handles = scheduler.getTaskHandlesByPriority(priority);
+        CHECK(handles == loaded->getTaskHandlesByPriority(priority));
+        for (auto handle : handles) {
+            CHECK(after.name(handle) == before.name(handle));
+            CHECK(after.duration(handle) == before.duration(handle));
+            CHECK(after.priority(handle) == before.priority(handle));
+            CHECK(after.deadline(handle) == before.deadline(handle));
+            CHECK(after.isCompleted(handle) == before.isCompleted(handle));
+            CHECK(after.scheduledTime(handle) == before.scheduledTime(handle));
+            CHECK(loaded->getTaskLane(handle) == scheduler.getTaskLane(handle));
+        }
+    }
+
+    // Events keep their ids, lanes and rules
+    auto events = [&](const TaskScheduler& s) {
+        std::vector<std::pair<std::string, system_clock::time_point>> result;
+        for (const auto& event : s.getCalendarEvents(origin, origin + hours(24 * 7))) {
+            result.emplace_back(event.description, event.start);
+        }
+        return result;
+    };
+    CHECK(events(*loaded) == events(scheduler));
+    CHECK(loaded->removeCalendarEvent(meeting));
+    CHECK(loaded->removeCalendarEvent(standup));
+    CHECK(loaded->getCalendarEvents(origin, origin + hours(24 * 7)).empty());
+
+    // A pass over the loaded plan changes nothing, and new tasks go after it
+    loaded = TaskScheduler::loadSnapshot(path);
+    loaded->rescheduleTasks();
+    for (auto handle : scheduler.getTaskHandlesByPriority(Priority::LOW)) {
+        CHECK(loaded->getTaskStore().scheduledTime(handle) == before.scheduledTime(handle));
+    }
+    auto added = loaded->addTask("late", minutes(10), Priority::LOW, origin + hours(48));
+    CHECK(added != TaskStore::kInvalidHandle && loaded->getTaskStore().name(added) == "late");
+
+    CHECK(!TaskScheduler::loadSnapshot(path + ".missing"));
+    std::filesystem::remove(path);
+}
+
+}
+
+int main() {
+    testRoundTrip();
+    return checkResult();
+}
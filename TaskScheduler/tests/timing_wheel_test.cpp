@@ -0,0 +1,148 @@
+#include "../include/TimingWheel.hpp"
+#include "../include/TaskScheduler.hpp"
+#include "Check.hpp"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono;
+
+void testFireAndCancel() {
+    TimingWheel wheel(100);
+    std::vector<std::pair<std::uint64_t, TimingWheel::Tick>> fired;
+    auto record = [&](std::uint64_t payload, TimingWheel::Tick tick) { fired.emplace_back(payload, tick); };
+
+    auto soon = wheel.arm(105, 1);
+    wheel.arm(100 + 64 * 64 + 3, 2);   // two levels up
+    auto cancelled = wheel.arm(140, 3);
+    wheel.arm(90, 4);                  // overdue, fires on the next advance
+    CHECK(wheel.size() == 4);
+    CHECK(wheel.cancel(cancelled));
+    CHECK(!wheel.cancel(cancelled));
+    CHECK(wheel.size() == 3);
+    CHECK(wheel.nextExpiry() && *wheel.nextExpiry() <= 100);
+
+    wheel.advance(104, record);
+    CHECK(fired == (std::vector<std::pair<std::uint64_t, TimingWheel::Tick>>{{4, 90}}));
+    wheel.advance(105, record);
+    CHECK(fired.size() == 2 && fired.back().first == 1);
+    CHECK(!wheel.cancel(soon));        // already fired
+    wheel.advance(100 + 64 * 64 + 2, record);
+    CHECK(fired.size() == 2);
+    wheel.advance(100 + 64 * 64 + 3, record);
+    CHECK(fired.size() == 3 && fired.back() == std::make_pair(std::uint64_t(2), TimingWheel::Tick(100 + 64 * 64 + 3)));
+    CHECK(wheel.size() == 0 && !wheel.nextExpiry());
+}
+
+// Every timer fires once, at the first advance that reaches its tick, in
+// tick order; cancelled ones never fire. Ticks span every level and the
+// overflow list.
+void testAgainstModel() {
+    std::mt19937_64 random(5);
+    TimingWheel wheel(0);
+    std::map<std::uint64_t, std::pair<TimingWheel::TimerId, TimingWheel::Tick>> live;
+    std::uint64_t payload = 0;
+    TimingWheel::Tick now = 0;
+
+    for (int round = 0; round < 3000; ++round) {
+        for (int i = random() % 4; i > 0; --i) {
+            int level = static_cast<int>(random() % 8);
+            TimingWheel::Tick span = TimingWheel::Tick(1) << (6 * level);
+            TimingWheel::Tick when = now + static_cast<TimingWheel::Tick>(random() % span) - 2;
+            live[payload] = {wheel.arm(when, payload), when};
+            ++payload;
+        }
+        if (!live.empty() && random() % 3 == 0) {
+            auto it = live.begin();
+            std::advance(it, random() % live.size());
+            CHECK(wheel.cancel(it->second.first));
+            live.erase(it);
+        }
+        CHECK(wheel.size() == live.size());
+
+        TimingWheel::Tick target = now + static_cast<TimingWheel::Tick>(random() % (TimingWheel::Tick(1) << (6 * (random() % 5))));
+        if (auto next = wheel.nextExpiry()) {
+            for (const auto& timer : live) {
+                CHECK(*next <= std::max(timer.second.second, now));
+            }
+        }
+        TimingWheel::Tick last = std::numeric_limits<TimingWheel::Tick>::min();
+        wheel.advance(target, [&](std::uint64_t fired, TimingWheel::Tick tick) {
+            auto it = live.find(fired);
+            CHECK(it != live.end() && it->second.second == tick && tick <= target);
+            // Timers overdue when armed fire first, in any order
+            if (tick >= now) {
+                CHECK(tick >= last);
+                last = tick;
+            }
+            if (it != live.end()) {
+                live.erase(it);
+            }
+        });
+        now = target;
+        CHECK(wheel.now() == now);
+        for (const auto& timer : live) {
+            CHECK(timer.second.second > now);
+        }
+    }
+}
+
+// START notifications follow the plan: cancelled when a task loses its
+// slot, including when a full pass or a lane change drops every placement
+void testSchedulerNotifications() {
+    using Notification = TaskScheduler::Notification;
+    for (int mode = 0; mode < 3; ++mode) {
+        auto now = system_clock::now();
+        TaskScheduler scheduler;
+        std::mutex mutex;
+        std::vector<TaskScheduler::TaskHandle> started;
+        scheduler.startNotifications(
+            [&](TaskScheduler::TaskHandle handle, Notification event) {
+                if (event == Notification::START) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    started.push_back(handle);
+                }
+            },
+            milliseconds(10));
+        scheduler.addCalendarEvent(now - hours(1), now + milliseconds(300), "busy");
+        auto a = scheduler.addTask("a", minutes(1), Priority::LOW, now + hours(5));
+        auto b = scheduler.addTask("b", minutes(1), Priority::LOW, now + hours(5));
+        scheduler.scheduleTasks();
+
+        if (mode > 0) {
+            // Push both beyond a short horizon, into the backlog
+            scheduler.setSchedulingHorizon(minutes(10));
+            scheduler.addCalendarEvent(now, now + hours(1), "all");
+            if (mode == 1) {
+                scheduler.addDependency(b, a);
+            } else {
+                scheduler.setLaneCount(2);
+                scheduler.addCalendarEvent(now, now + hours(1), "second", 1);
+            }
+            scheduler.rescheduleTasks();
+        }
+        std::this_thread::sleep_for(milliseconds(600));
+        scheduler.stopNotifications();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (mode == 0) {
+            CHECK(started == std::vector<TaskScheduler::TaskHandle>{a});
+        } else {
+            CHECK(started.empty());
+        }
+    }
+}
+
+}
+
+int main() {
+    testFireAndCancel();
+    testAgainstModel();
+    testSchedulerNotifications();
+    return checkResult();
+}